@@ -0,0 +1,107 @@
+// Copyright Istio Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/common/cluster_metadata.h"
+
+#include "envoy/registry/registry.h"
+
+namespace Istio {
+namespace Common {
+
+namespace {
+
+using Envoy::ProtobufWkt::Struct;
+
+const Struct* firstService(const Struct& data) {
+  const auto it = data.fields().find("services");
+  if (it == data.fields().end()) {
+    return nullptr;
+  }
+  const auto& services = it->second.list_value();
+  if (services.values_size() == 0) {
+    return nullptr;
+  }
+  return &services.values(0).struct_value();
+}
+
+std::string stringField(const Struct* data, const std::string& name) {
+  if (data == nullptr) {
+    return "";
+  }
+  const auto it = data->fields().find(name);
+  return it != data->fields().end() ? it->second.string_value() : "";
+}
+
+absl::optional<std::string> optionalField(const Struct* data, const std::string& name) {
+  if (data == nullptr) {
+    return absl::nullopt;
+  }
+  const auto it = data->fields().find(name);
+  if (it == data->fields().end()) {
+    return absl::nullopt;
+  }
+  return it->second.string_value();
+}
+
+bool boolField(const Struct& data, const std::string& name) {
+  const auto it = data.fields().find(name);
+  return it != data.fields().end() && it->second.bool_value();
+}
+
+ClusterMetadata::StatNameRef statName(const absl::optional<std::string>& value,
+                                      Envoy::Stats::SymbolTable& symbol_table) {
+  if (!value.has_value() || value->empty()) {
+    return nullptr;
+  }
+  return std::make_shared<const Envoy::Stats::StatNameDynamicStorage>(*value, symbol_table);
+}
+
+} // namespace
+
+ClusterMetadata::ClusterMetadata(const Struct& data)
+    : has_service_(firstService(data) != nullptr),
+      service_host_(optionalField(firstService(data), "host")),
+      service_name_(optionalField(firstService(data), "name")),
+      service_namespace_(optionalField(firstService(data), "namespace")),
+      external_(boolField(data, "external")), disable_mx_(boolField(data, "disable_mx")),
+      disable_alpn_override_(stringField(&data, "alpn_override") == "false") {}
+
+const ClusterMetadata* ClusterMetadata::get(const Envoy::Upstream::ClusterInfo& cluster) {
+  return cluster.typedMetadata().get<ClusterMetadata>(std::string(ClusterMetadataName));
+}
+
+const ClusterMetadata::ServiceStatNames&
+ClusterMetadata::serviceStatNames(Envoy::Stats::SymbolTable& symbol_table) const {
+  absl::call_once(stat_names_once_, [this, &symbol_table]() {
+    stat_names_.host_ = statName(service_host_, symbol_table);
+    stat_names_.name_ = statName(service_name_, symbol_table);
+    stat_names_.namespace_ = statName(service_namespace_, symbol_table);
+  });
+  return stat_names_;
+}
+
+std::unique_ptr<const Envoy::Config::TypedMetadata::Object>
+ClusterMetadataFactory::parse(const Envoy::ProtobufWkt::Struct& data) const {
+  return std::make_unique<ClusterMetadata>(data);
+}
+
+std::unique_ptr<const Envoy::Config::TypedMetadata::Object>
+ClusterMetadataFactory::parse(const Envoy::ProtobufWkt::Any&) const {
+  return nullptr;
+}
+
+REGISTER_FACTORY(ClusterMetadataFactory, Envoy::Upstream::ClusterTypedMetadataFactory);
+
+} // namespace Common
+} // namespace Istio
@@ -0,0 +1,84 @@
+// Copyright Istio Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "envoy/config/typed_metadata.h"
+#include "envoy/stats/symbol_table.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/protobuf/protobuf.h"
+#include "source/common/stats/symbol_table.h"
+
+#include "absl/base/call_once.h"
+#include "absl/types/optional.h"
+
+namespace Istio {
+namespace Common {
+
+// Filter metadata namespace of the cluster metadata set by Istio.
+constexpr absl::string_view ClusterMetadataName = "istio";
+
+// Digest of the Istio cluster metadata. It is parsed once per cluster
+// version by the cluster typed metadata factory, so that the filters do not
+// need to walk the metadata struct on every request.
+class ClusterMetadata : public Envoy::Config::TypedMetadata::Object {
+public:
+  explicit ClusterMetadata(const Envoy::ProtobufWkt::Struct& data);
+
+  // Returns the digest of the cluster, or nullptr if the cluster has no Istio
+  // metadata.
+  static const ClusterMetadata* get(const Envoy::Upstream::ClusterInfo& cluster);
+
+  using StatNameRef = std::shared_ptr<const Envoy::Stats::StatNameDynamicStorage>;
+  // Stat names of the service fields, nullptr for the empty fields.
+  struct ServiceStatNames {
+    StatNameRef host_;
+    StatNameRef name_;
+    StatNameRef namespace_;
+  };
+  // Returns the service stat names, interned in the symbol table on first use.
+  // The symbol table must be the same for all the callers.
+  const ServiceStatNames& serviceStatNames(Envoy::Stats::SymbolTable& symbol_table) const;
+
+  // Whether the cluster lists any service.
+  const bool has_service_;
+  // Fields of the first service, unset when the field is absent. An absent
+  // name is derived by the filters from the host in effect for the request.
+  const absl::optional<std::string> service_host_;
+  const absl::optional<std::string> service_name_;
+  const absl::optional<std::string> service_namespace_;
+  // Whether the cluster is external to the mesh.
+  const bool external_;
+  // Whether the metadata exchange is disabled for the cluster.
+  const bool disable_mx_;
+  // Whether the ALPN override is disabled for the cluster.
+  const bool disable_alpn_override_;
+
+private:
+  mutable absl::once_flag stat_names_once_;
+  mutable ServiceStatNames stat_names_;
+};
+
+class ClusterMetadataFactory : public Envoy::Upstream::ClusterTypedMetadataFactory {
+public:
+  std::string name() const override { return std::string(ClusterMetadataName); }
+  std::unique_ptr<const Envoy::Config::TypedMetadata::Object>
+  parse(const Envoy::ProtobufWkt::Struct& data) const override;
+  std::unique_ptr<const Envoy::Config::TypedMetadata::Object>
+  parse(const Envoy::ProtobufWkt::Any& data) const override;
+};
+
+} // namespace Common
+} // namespace Istio
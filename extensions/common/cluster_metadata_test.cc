@@ -0,0 +1,150 @@
+// Copyright Istio Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/common/cluster_metadata.h"
+
+#include "source/common/config/metadata.h"
+
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Istio {
+namespace Common {
+
+using ClusterTypedMetadata =
+    Envoy::Config::TypedMetadataImpl<Envoy::Upstream::ClusterTypedMetadataFactory>;
+
+const ClusterMetadata* parse(const ClusterTypedMetadata& typed_metadata) {
+  return typed_metadata.get<ClusterMetadata>(std::string(ClusterMetadataName));
+}
+
+TEST(ClusterMetadataTest, Service) {
+  const auto metadata =
+      Envoy::TestUtility::parseYaml<envoy::config::core::v3::Metadata>(R"EOF(
+        filter_metadata:
+          istio:
+            services:
+            - host: foo.default.svc.cluster.local
+              name: foo-service
+              namespace: default
+            - host: bar.default.svc.cluster.local
+      )EOF");
+  const ClusterTypedMetadata typed_metadata(metadata);
+  const auto* cluster = parse(typed_metadata);
+  ASSERT_NE(cluster, nullptr);
+  EXPECT_TRUE(cluster->has_service_);
+  EXPECT_EQ(cluster->service_host_, "foo.default.svc.cluster.local");
+  EXPECT_EQ(cluster->service_name_, "foo-service");
+  EXPECT_EQ(cluster->service_namespace_, "default");
+  EXPECT_FALSE(cluster->external_);
+  EXPECT_FALSE(cluster->disable_mx_);
+  EXPECT_FALSE(cluster->disable_alpn_override_);
+
+  Envoy::Stats::SymbolTableImpl symbol_table;
+  const auto& names = cluster->serviceStatNames(symbol_table);
+  ASSERT_NE(names.host_, nullptr);
+  EXPECT_EQ(symbol_table.toString(names.host_->statName()), "foo.default.svc.cluster.local");
+  ASSERT_NE(names.name_, nullptr);
+  EXPECT_EQ(symbol_table.toString(names.name_->statName()), "foo-service");
+  ASSERT_NE(names.namespace_, nullptr);
+  EXPECT_EQ(symbol_table.toString(names.namespace_->statName()), "default");
+  EXPECT_EQ(&cluster->serviceStatNames(symbol_table), &names);
+}
+
+TEST(ClusterMetadataTest, HostOnly) {
+  const auto metadata =
+      Envoy::TestUtility::parseYaml<envoy::config::core::v3::Metadata>(R"EOF(
+        filter_metadata:
+          istio:
+            services:
+            - host: foo.default.svc.cluster.local
+      )EOF");
+  const ClusterTypedMetadata typed_metadata(metadata);
+  const auto* cluster = parse(typed_metadata);
+  ASSERT_NE(cluster, nullptr);
+  EXPECT_TRUE(cluster->has_service_);
+  EXPECT_EQ(cluster->service_host_, "foo.default.svc.cluster.local");
+  // The name is derived by the filters from the host in effect.
+  EXPECT_FALSE(cluster->service_name_.has_value());
+  EXPECT_FALSE(cluster->service_namespace_.has_value());
+
+  Envoy::Stats::SymbolTableImpl symbol_table;
+  const auto& names = cluster->serviceStatNames(symbol_table);
+  ASSERT_NE(names.host_, nullptr);
+  EXPECT_EQ(names.name_, nullptr);
+  EXPECT_EQ(names.namespace_, nullptr);
+}
+
+TEST(ClusterMetadataTest, EmptyHost) {
+  const auto metadata =
+      Envoy::TestUtility::parseYaml<envoy::config::core::v3::Metadata>(R"EOF(
+        filter_metadata:
+          istio:
+            services:
+            - host: ""
+              namespace: ""
+      )EOF");
+  const ClusterTypedMetadata typed_metadata(metadata);
+  const auto* cluster = parse(typed_metadata);
+  ASSERT_NE(cluster, nullptr);
+  EXPECT_TRUE(cluster->has_service_);
+  // The empty fields are present and override the request values.
+  ASSERT_TRUE(cluster->service_host_.has_value());
+  EXPECT_EQ(cluster->service_host_, "");
+  ASSERT_TRUE(cluster->service_namespace_.has_value());
+  EXPECT_EQ(cluster->service_namespace_, "");
+  EXPECT_FALSE(cluster->service_name_.has_value());
+
+  Envoy::Stats::SymbolTableImpl symbol_table;
+  const auto& names = cluster->serviceStatNames(symbol_table);
+  EXPECT_EQ(names.host_, nullptr);
+  EXPECT_EQ(names.name_, nullptr);
+  EXPECT_EQ(names.namespace_, nullptr);
+}
+
+TEST(ClusterMetadataTest, Flags) {
+  const auto metadata =
+      Envoy::TestUtility::parseYaml<envoy::config::core::v3::Metadata>(R"EOF(
+        filter_metadata:
+          istio:
+            external: true
+            disable_mx: true
+            alpn_override: "false"
+      )EOF");
+  const ClusterTypedMetadata typed_metadata(metadata);
+  const auto* cluster = parse(typed_metadata);
+  ASSERT_NE(cluster, nullptr);
+  EXPECT_FALSE(cluster->has_service_);
+  EXPECT_FALSE(cluster->service_host_.has_value());
+  EXPECT_FALSE(cluster->service_name_.has_value());
+  EXPECT_TRUE(cluster->external_);
+  EXPECT_TRUE(cluster->disable_mx_);
+  EXPECT_TRUE(cluster->disable_alpn_override_);
+}
+
+TEST(ClusterMetadataTest, NoMetadata) {
+  const auto metadata =
+      Envoy::TestUtility::parseYaml<envoy::config::core::v3::Metadata>(R"EOF(
+        filter_metadata:
+          other:
+            external: true
+      )EOF");
+  const ClusterTypedMetadata typed_metadata(metadata);
+  EXPECT_EQ(parse(typed_metadata), nullptr);
+}
+
+} // namespace Common
+} // namespace Istio
@@ -0,0 +1,99 @@
+// Copyright Istio Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/common/host_metadata.h"
+
+#include "envoy/singleton/manager.h"
+
+#include "source/common/network/utility.h"
+
+namespace Istio {
+namespace Common {
+
+SINGLETON_MANAGER_REGISTRATION(istio_host_metadata_cache);
+
+HostMetadataCache::HostMetadataCache(Envoy::ThreadLocal::SlotAllocator& tls) : tls_(tls) {
+  tls_.set([](Envoy::Event::Dispatcher&) { return std::make_shared<ThreadLocalCache>(); });
+}
+
+std::shared_ptr<HostMetadataCache>
+HostMetadataCache::get(Envoy::Server::Configuration::ServerFactoryContext& context) {
+  return context.singletonManager().getTyped<HostMetadataCache>(
+      SINGLETON_MANAGER_REGISTERED_NAME(istio_host_metadata_cache),
+      [&context] { return std::make_shared<HostMetadataCache>(context.threadLocal()); });
+}
+
+HostMetadataConstSharedPtr
+HostMetadataCache::lookup(const Envoy::Upstream::HostDescription& host) const {
+  const auto metadata = host.metadata();
+  if (!metadata) {
+    return nullptr;
+  }
+  auto& cache = *tls_;
+  const auto it = cache.entries_.find(metadata.get());
+  if (it != cache.entries_.end()) {
+    const auto entry = it->second;
+    // An expired entry belongs to a released instance at the same address.
+    if (!entry->metadata_.expired()) {
+      cache.lru_.splice(cache.lru_.begin(), cache.lru_, entry);
+      return entry->value_;
+    }
+    cache.erase(entry);
+  }
+  // Drop the entries of the hosts that were removed or updated first.
+  while (!cache.lru_.empty() && cache.lru_.back().metadata_.expired()) {
+    cache.erase(std::prev(cache.lru_.end()));
+  }
+  if (cache.entries_.size() >= MaxSize) {
+    for (auto entry = cache.lru_.begin(); entry != cache.lru_.end();) {
+      const auto next = std::next(entry);
+      if (entry->metadata_.expired()) {
+        cache.erase(entry);
+      }
+      entry = next;
+    }
+    // Then the least recently used ones.
+    while (cache.entries_.size() >= MaxSize) {
+      cache.erase(std::prev(cache.lru_.end()));
+    }
+  }
+  auto value = std::make_shared<const HostMetadata>(derive(*metadata));
+  cache.lru_.push_front({metadata.get(), metadata, value});
+  cache.entries_.emplace(metadata.get(), cache.lru_.begin());
+  return value;
+}
+
+HostMetadata HostMetadataCache::derive(const envoy::config::core::v3::Metadata& metadata) {
+  HostMetadata result;
+  const auto& filter_metadata = metadata.filter_metadata();
+  const auto& istio = filter_metadata.find("istio");
+  if (istio != filter_metadata.end()) {
+    const auto& workload_it = istio->second.fields().find("workload");
+    if (workload_it != istio->second.fields().end()) {
+      result.workload_ = convertEndpointMetadata(workload_it->second.string_value());
+    }
+  }
+  const auto& original_dst = filter_metadata.find("envoy.filters.listener.original_dst");
+  if (original_dst != filter_metadata.end()) {
+    const auto& destination_it = original_dst->second.fields().find("local");
+    if (destination_it != original_dst->second.fields().end()) {
+      result.original_dst_ = Envoy::Network::Utility::parseInternetAddressAndPortNoThrow(
+          destination_it->second.string_value(), /*v6only=*/false);
+    }
+  }
+  return result;
+}
+
+} // namespace Common
+} // namespace Istio
@@ -0,0 +1,88 @@
+// Copyright Istio Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "envoy/config/core/v3/base.pb.h"
+#include "envoy/network/address.h"
+#include "envoy/server/factory_context.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/thread_local/thread_local.h"
+#include "envoy/upstream/host_description.h"
+
+#include "extensions/common/metadata_object.h"
+
+#include <list>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Istio {
+namespace Common {
+
+// Values derived from the metadata of an upstream host.
+struct HostMetadata {
+  // Peer workload decoded from the "istio" endpoint metadata.
+  absl::optional<WorkloadMetadataObject> workload_;
+  // Destination address recorded by the original destination listener
+  // filter, set for the internal hosts.
+  Envoy::Network::Address::InstanceConstSharedPtr original_dst_;
+};
+
+using HostMetadataConstSharedPtr = std::shared_ptr<const HostMetadata>;
+
+// Derives the host metadata once per host metadata version, and caches it on
+// each worker. The host metadata is immutable and replaced on update, so the
+// entries are keyed by the metadata instance. The entries only hold a weak
+// reference to it, and are dropped once it is released or when they are the
+// least recently used ones of a full cache.
+class HostMetadataCache : public Envoy::Singleton::Instance {
+public:
+  explicit HostMetadataCache(Envoy::ThreadLocal::SlotAllocator& tls);
+
+  // Returns the cache shared by the filters.
+  static std::shared_ptr<HostMetadataCache>
+  get(Envoy::Server::Configuration::ServerFactoryContext& context);
+
+  // Returns the derived metadata of the host, or nullptr if the host has no
+  // metadata.
+  HostMetadataConstSharedPtr lookup(const Envoy::Upstream::HostDescription& host) const;
+
+  // Decodes the host metadata.
+  static HostMetadata derive(const envoy::config::core::v3::Metadata& metadata);
+
+  static constexpr size_t MaxSize = 4096;
+
+private:
+  struct Entry {
+    const envoy::config::core::v3::Metadata* key_;
+    std::weak_ptr<const envoy::config::core::v3::Metadata> metadata_;
+    HostMetadataConstSharedPtr value_;
+  };
+  using EntryList = std::list<Entry>;
+  struct ThreadLocalCache : public Envoy::ThreadLocal::ThreadLocalObject {
+    void erase(EntryList::iterator entry) {
+      entries_.erase(entry->key_);
+      lru_.erase(entry);
+    }
+    // Most recently used first.
+    EntryList lru_;
+    absl::flat_hash_map<const envoy::config::core::v3::Metadata*, EntryList::iterator> entries_;
+  };
+  mutable Envoy::ThreadLocal::TypedSlot<ThreadLocalCache> tls_;
+};
+
+using HostMetadataCacheSharedPtr = std::shared_ptr<HostMetadataCache>;
+
+} // namespace Common
+} // namespace Istio
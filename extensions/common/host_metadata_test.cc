@@ -0,0 +1,153 @@
+// Copyright Istio Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "extensions/common/host_metadata.h"
+
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Istio {
+namespace Common {
+
+using ::testing::NiceMock;
+using ::testing::Return;
+
+using MetadataSharedPtr = std::shared_ptr<envoy::config::core::v3::Metadata>;
+
+MetadataSharedPtr parseMetadata(const std::string& yaml) {
+  return std::make_shared<envoy::config::core::v3::Metadata>(
+      Envoy::TestUtility::parseYaml<envoy::config::core::v3::Metadata>(yaml));
+}
+
+TEST(HostMetadataTest, Derive) {
+  const auto metadata = parseMetadata(R"EOF(
+    filter_metadata:
+      istio:
+        workload: foo-service-v2;default;foo-service;v2;my-cluster
+      envoy.filters.listener.original_dst:
+        local: 127.0.0.100:80
+  )EOF");
+  const auto result = HostMetadataCache::derive(*metadata);
+  ASSERT_TRUE(result.workload_.has_value());
+  EXPECT_EQ(result.workload_->workload_name_, "foo-service-v2");
+  EXPECT_EQ(result.workload_->namespace_name_, "default");
+  EXPECT_EQ(result.workload_->canonical_name_, "foo-service");
+  ASSERT_NE(result.original_dst_, nullptr);
+  EXPECT_EQ(result.original_dst_->asString(), "127.0.0.100:80");
+}
+
+TEST(HostMetadataTest, DeriveEmpty) {
+  const auto metadata = parseMetadata(R"EOF(
+    filter_metadata:
+      envoy.filters.listener.original_dst:
+        local: not-an-address
+  )EOF");
+  const auto result = HostMetadataCache::derive(*metadata);
+  EXPECT_FALSE(result.workload_.has_value());
+  EXPECT_EQ(result.original_dst_, nullptr);
+}
+
+TEST(HostMetadataTest, Lookup) {
+  NiceMock<Envoy::ThreadLocal::MockInstance> tls;
+  HostMetadataCache cache(tls);
+  NiceMock<Envoy::Upstream::MockHostDescription> host;
+
+  EXPECT_CALL(host, metadata()).WillOnce(Return(nullptr));
+  EXPECT_EQ(cache.lookup(host), nullptr);
+
+  auto metadata = parseMetadata(R"EOF(
+    filter_metadata:
+      istio:
+        workload: foo-service-v2;default;foo-service;v2;my-cluster
+  )EOF");
+  ON_CALL(host, metadata()).WillByDefault(Return(metadata));
+  const auto first = cache.lookup(host);
+  ASSERT_NE(first, nullptr);
+  ASSERT_TRUE(first->workload_.has_value());
+  EXPECT_EQ(first->workload_->workload_name_, "foo-service-v2");
+  EXPECT_EQ(cache.lookup(host), first);
+
+  // An update of the host metadata replaces the instance.
+  auto updated = parseMetadata(R"EOF(
+    filter_metadata:
+      istio:
+        workload: foo-service-v3;default;foo-service;v3;my-cluster
+  )EOF");
+  ON_CALL(host, metadata()).WillByDefault(Return(updated));
+  const auto second = cache.lookup(host);
+  ASSERT_NE(second, nullptr);
+  EXPECT_NE(second, first);
+  EXPECT_EQ(second->workload_->workload_name_, "foo-service-v3");
+}
+
+TEST(HostMetadataTest, LookupDoesNotPinMetadata) {
+  NiceMock<Envoy::ThreadLocal::MockInstance> tls;
+  HostMetadataCache cache(tls);
+  NiceMock<Envoy::Upstream::MockHostDescription> host;
+  MetadataSharedPtr current = parseMetadata(R"EOF(
+    filter_metadata:
+      istio:
+        workload: foo-service-v2;default;foo-service;v2;my-cluster
+  )EOF");
+  ON_CALL(host, metadata()).WillByDefault([&current]() { return current; });
+  const auto first = cache.lookup(host);
+  ASSERT_NE(first, nullptr);
+
+  // The cache does not keep the released metadata alive.
+  std::weak_ptr<envoy::config::core::v3::Metadata> released = current;
+  current = parseMetadata(R"EOF(
+    filter_metadata:
+      istio:
+        workload: foo-service-v3;default;foo-service;v3;my-cluster
+  )EOF");
+  EXPECT_TRUE(released.expired());
+  const auto second = cache.lookup(host);
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(second->workload_->workload_name_, "foo-service-v3");
+}
+
+TEST(HostMetadataTest, LookupEvictsLeastRecentlyUsed) {
+  NiceMock<Envoy::ThreadLocal::MockInstance> tls;
+  HostMetadataCache cache(tls);
+  NiceMock<Envoy::Upstream::MockHostDescription> host;
+  MetadataSharedPtr current;
+  ON_CALL(host, metadata()).WillByDefault([&current]() { return current; });
+
+  std::vector<MetadataSharedPtr> metadata;
+  std::vector<HostMetadataConstSharedPtr> values;
+  for (size_t i = 0; i < HostMetadataCache::MaxSize; i++) {
+    current = metadata.emplace_back(std::make_shared<envoy::config::core::v3::Metadata>());
+    values.push_back(cache.lookup(host));
+  }
+  // Touch the oldest entry, then overflow the cache.
+  current = metadata[0];
+  EXPECT_EQ(cache.lookup(host), values[0]);
+  current = std::make_shared<envoy::config::core::v3::Metadata>();
+  cache.lookup(host);
+
+  current = metadata[0];
+  EXPECT_EQ(cache.lookup(host), values[0]);
+  current = metadata[2];
+  EXPECT_EQ(cache.lookup(host), values[2]);
+  // The least recently used entry was derived again.
+  current = metadata[1];
+  EXPECT_NE(cache.lookup(host), values[1]);
+}
+
+} // namespace Common
+} // namespace Istio
@@ -18,6 +18,7 @@
 #include "source/common/common/hash.h"
 #include "source/common/protobuf/utility.h"
 
+#include "absl/strings/match.h"
 #include "absl/strings/str_join.h"
 
 namespace Istio {
@@ -316,6 +317,21 @@ WorkloadMetadataObject::getField(absl::string_view field_name) const {
       return instance_name_;
     }
   }
+  if (absl::StartsWith(field_name, LabelsFieldPrefix)) {
+    if (const auto value = getLabel(field_name.substr(LabelsFieldPrefix.size()));
+        value.has_value()) {
+      return *value;
+    }
+  }
+  return {};
+}
+
+absl::optional<absl::string_view> WorkloadMetadataObject::getLabel(absl::string_view key) const {
+  for (const auto& [name, value] : labels_) {
+    if (name == key) {
+      return value;
+    }
+  }
   return {};
 }
 
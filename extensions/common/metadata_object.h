@@ -30,6 +30,12 @@ namespace Common {
 constexpr absl::string_view DownstreamPeer = "downstream_peer";
 constexpr absl::string_view UpstreamPeer = "upstream_peer";
 
+// Filter state key to store the typed peer metadata handle under. The handle
+// is stored alongside the CEL state under the keys above, with the same state
+// type and life span, and can be read directly without parsing.
+constexpr absl::string_view DownstreamPeerObject = "downstream_peer_obj";
+constexpr absl::string_view UpstreamPeerObject = "upstream_peer_obj";
+
 // Special filter state key to indicate the filter is done looking for peer metadata.
 // This is used by network metadata exchange on failure.
 constexpr absl::string_view NoPeer = "peer_not_found";
@@ -77,6 +83,8 @@ constexpr absl::string_view WorkloadNameToken = "workload";
 constexpr absl::string_view WorkloadTypeToken = "type";
 constexpr absl::string_view InstanceNameToken = "name";
 constexpr absl::string_view LabelsToken = "labels";
+// Prefix of the field names resolving to the labels, e.g. "labels.role".
+constexpr absl::string_view LabelsFieldPrefix = "labels.";
 constexpr absl::string_view IdentityToken = "identity";
 
 constexpr absl::string_view InstanceMetadataField = "NAME";
@@ -110,6 +118,7 @@ public:
   FieldType getField(absl::string_view) const override;
   void setLabels(std::vector<std::pair<std::string, std::string>> labels) { labels_ = labels; }
   std::vector<std::pair<std::string, std::string>> getLabels() const { return labels_; }
+  absl::optional<absl::string_view> getLabel(absl::string_view key) const;
 
   const std::string instance_name_;
   const std::string cluster_name_;
@@ -124,6 +133,31 @@ public:
   std::vector<std::pair<std::string, std::string>> labels_;
 };
 
+using WorkloadMetadataObjectConstSharedPtr = std::shared_ptr<const WorkloadMetadataObject>;
+
+// Filter state object referencing a shared, immutable workload metadata
+// object, e.g. one owned by the workload discovery index.
+class WorkloadMetadataHandle : public Envoy::StreamInfo::FilterState::Object {
+public:
+  explicit WorkloadMetadataHandle(WorkloadMetadataObjectConstSharedPtr workload)
+      : workload_(std::move(workload)) {}
+
+  const WorkloadMetadataObjectConstSharedPtr& workload() const { return workload_; }
+
+  Envoy::ProtobufTypes::MessagePtr serializeAsProto() const override {
+    return workload_->serializeAsProto();
+  }
+  absl::optional<std::string> serializeAsString() const override {
+    return workload_->serializeAsString();
+  }
+  bool hasFieldSupport() const override { return true; }
+  using Envoy::StreamInfo::FilterState::Object::FieldType;
+  FieldType getField(absl::string_view field) const override { return workload_->getField(field); }
+
+private:
+  const WorkloadMetadataObjectConstSharedPtr workload_;
+};
+
 // Parse string workload type.
 WorkloadType fromSuffix(absl::string_view suffix);
 
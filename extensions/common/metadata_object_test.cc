@@ -79,6 +79,18 @@ TEST(WorkloadMetadataObjectTest, ConversionWithLabels) {
   EXPECT_EQ(obj3->getLabels().size(), 0);
 }
 
+TEST(WorkloadMetadataObjectTest, LabelFields) {
+  WorkloadMetadataObject deploy("pod-foo-1234", "my-cluster", "default", "foo", "foo-service",
+                                "v1alpha3", "", "", WorkloadType::Deployment, "");
+  deploy.setLabels({{"role", "gateway"}, {"label2", "value2"}});
+  EXPECT_EQ(deploy.getLabel("role"), "gateway");
+  EXPECT_EQ(deploy.getLabel("missing"), absl::nullopt);
+  EXPECT_EQ(absl::get<absl::string_view>(deploy.getField("labels.role")), "gateway");
+  EXPECT_EQ(absl::get<absl::string_view>(deploy.getField("labels.label2")), "value2");
+  EXPECT_TRUE(absl::holds_alternative<absl::monostate>(deploy.getField("labels.missing")));
+  EXPECT_TRUE(absl::holds_alternative<absl::monostate>(deploy.getField("role")));
+}
+
 TEST(WorkloadMetadataObjectTest, Conversion) {
   {
     const auto r = convertBaggageToWorkloadMetadata(
@@ -14,6 +14,8 @@
 
 #include "source/extensions/common/workload_discovery/api.h"
 
+#include <cstring>
+
 #include "envoy/registry/registry.h"
 #include "envoy/server/bootstrap_extension_config.h"
 #include "envoy/server/factory_context.h"
@@ -28,6 +30,7 @@
 #include "source/extensions/common/workload_discovery/extension.pb.h"
 #include "source/extensions/common/workload_discovery/extension.pb.validate.h"
 
+
 namespace Envoy::Extensions::Common::WorkloadDiscovery {
 namespace {
 constexpr absl::string_view DefaultNamespace = "default";
@@ -71,8 +74,126 @@ Istio::Common::WorkloadMetadataObject convert(const istio::workload::Workload& w
       workload.canonical_name(), workload.canonical_revision(), workload.canonical_name(),
       workload.canonical_revision(), workload_type, identity);
 }
+
 } // namespace
 
+AddressKey AddressKey::ipv6(absl::uint128 address) {
+  // The address bytes are in network order in the memory of the value.
+  std::array<uint8_t, 16> bytes;
+  memcpy(bytes.data(), &address, bytes.size());
+  static constexpr std::array<uint8_t, 12> MappedPrefix = {0, 0, 0, 0, 0,    0,
+                                                           0, 0, 0, 0, 0xff, 0xff};
+  if (memcmp(bytes.data(), MappedPrefix.data(), MappedPrefix.size()) == 0) {
+    uint32_t ipv4;
+    memcpy(&ipv4, bytes.data() + MappedPrefix.size(), sizeof(ipv4));
+    return AddressKey::ipv4(ipv4);
+  }
+  return {true, address};
+}
+
+std::optional<AddressKey> AddressKey::fromBytes(absl::string_view bytes) {
+  if (bytes.size() == 4) {
+    uint32_t address;
+    memcpy(&address, bytes.data(), sizeof(address));
+    return AddressKey::ipv4(address);
+  }
+  if (bytes.size() == 16) {
+    absl::uint128 address;
+    memcpy(&address, bytes.data(), sizeof(address));
+    return AddressKey::ipv6(address);
+  }
+  return {};
+}
+
+std::optional<AddressKey> AddressKey::fromAddress(const Network::Address::Instance& address) {
+  if (const auto* ip = address.ip(); ip != nullptr) {
+    if (const auto* ipv4 = ip->ipv4(); ipv4 != nullptr) {
+      return AddressKey::ipv4(ipv4->address());
+    }
+    if (const auto* ipv6 = ip->ipv6(); ipv6 != nullptr) {
+      return AddressKey::ipv6(ipv6->address());
+    }
+  }
+  return {};
+}
+
+WorkloadIndex::WorkloadIndex() {
+  const auto empty = std::make_shared<const Shard>();
+  shards_.fill(empty);
+}
+
+void WorkloadIndex::Builder::erase(const AddressKey& address) {
+  const size_t id = shardOf(address);
+  if (index_.shards_[id]->contains(address)) {
+    index_.size_ -= mutableShard(id).erase(address);
+  }
+}
+
+void WorkloadIndex::Builder::assign(const AddressKey& address,
+                                    const WorkloadMetadataObjectConstSharedPtr& workload) {
+  const size_t id = shardOf(address);
+  const auto it = index_.shards_[id]->find(address);
+  if (it != index_.shards_[id]->end() && it->second == workload) {
+    return;
+  }
+  if (mutableShard(id).insert_or_assign(address, workload).second) {
+    index_.size_++;
+  }
+}
+
+WorkloadIndex::Shard& WorkloadIndex::Builder::mutableShard(size_t id) {
+  auto& shard = copied_[id];
+  if (shard == nullptr) {
+    shard = std::make_shared<Shard>(*index_.shards_[id]);
+    index_.shards_[id] = shard;
+  }
+  return *shard;
+}
+
+void WorkloadIndexUpdater::reset(const std::vector<WorkloadEntry>& workloads) {
+  id_to_address_.clear();
+  WorkloadIndex::Builder builder{WorkloadIndex()};
+  for (const auto& entry : workloads) {
+    insert(builder, entry);
+  }
+  index_ = builder.build();
+}
+
+void WorkloadIndexUpdater::update(const std::vector<WorkloadEntry>& added,
+                                  const std::vector<std::string>& removed) {
+  // The delta is applied once. The shards it does not touch are shared with
+  // the current index, which may still be in use by the workers.
+  WorkloadIndex::Builder builder(*index_);
+  for (const auto& uid : removed) {
+    erase(builder, uid);
+  }
+  for (const auto& entry : added) {
+    erase(builder, entry.uid_);
+    insert(builder, entry);
+  }
+  index_ = builder.build();
+}
+
+void WorkloadIndexUpdater::erase(WorkloadIndex::Builder& builder, const std::string& uid) {
+  const auto it = id_to_address_.find(uid);
+  if (it == id_to_address_.end()) {
+    return;
+  }
+  for (const auto& address : it->second.addresses_) {
+    if (builder.get(address) == it->second.workload_) {
+      builder.erase(address);
+    }
+  }
+  id_to_address_.erase(it);
+}
+
+void WorkloadIndexUpdater::insert(WorkloadIndex::Builder& builder, const WorkloadEntry& entry) {
+  for (const auto& address : entry.addresses_) {
+    builder.assign(address, entry.workload_);
+  }
+  id_to_address_[entry.uid_] = {entry.workload_, entry.addresses_};
+}
+
 class WorkloadMetadataProviderImpl : public WorkloadMetadataProvider, public Singleton::Instance {
 public:
   WorkloadMetadataProviderImpl(const envoy::config::core::v3::ConfigSource& config_source,
@@ -87,61 +208,22 @@ public:
     subscription_.start();
   }
 
-  std::optional<Istio::Common::WorkloadMetadataObject>
+  WorkloadMetadataObjectConstSharedPtr
   GetMetadata(const Network::Address::InstanceConstSharedPtr& address) override {
-    if (address && address->ip()) {
-      if (const auto ipv4 = address->ip()->ipv4(); ipv4) {
-        uint32_t value = ipv4->address();
-        std::array<uint8_t, 4> output;
-        absl::little_endian::Store32(&output, value);
-        return tls_->get(std::string(output.begin(), output.end()));
-      } else if (const auto ipv6 = address->ip()->ipv6(); ipv6) {
-        const uint64_t high = absl::Uint128High64(ipv6->address());
-        const uint64_t low = absl::Uint128Low64(ipv6->address());
-        std::array<uint8_t, 16> output;
-        absl::little_endian::Store64(&output, low);
-        absl::little_endian::Store64(&output[8], high);
-        return tls_->get(std::string(output.begin(), output.end()));
+    if (address) {
+      if (const auto key = AddressKey::fromAddress(*address); key) {
+        return tls_->index_->get(*key);
       }
     }
-    return {};
+    return nullptr;
   }
 
 private:
-  using IdToAddress = absl::flat_hash_map<std::string, std::vector<std::string>>;
-  using IdToAddressSharedPtr = std::shared_ptr<IdToAddress>;
-  using AddressToWorkload = absl::flat_hash_map<std::string, Istio::Common::WorkloadMetadataObject>;
-  using AddressToWorkloadSharedPtr = std::shared_ptr<AddressToWorkload>;
-
+  // Holds the current index snapshot. The snapshots are immutable and shared
+  // by all workers, so the lookups are lock-free and the memory does not grow
+  // with the number of workers.
   struct ThreadLocalProvider : public ThreadLocal::ThreadLocalObject {
-    void reset(const AddressToWorkloadSharedPtr& index) { address_to_workload_ = *index; }
-    void update(const AddressToWorkloadSharedPtr& added_addresses,
-                const IdToAddressSharedPtr& added_ids,
-                const std::shared_ptr<std::vector<std::string>> removed) {
-      for (const auto& id : *removed) {
-        for (const auto& address : id_to_address_[id]) {
-          address_to_workload_.erase(address);
-        }
-        id_to_address_.erase(id);
-      }
-      for (const auto& [address, workload] : *added_addresses) {
-        address_to_workload_.emplace(address, workload);
-      }
-      for (const auto& [id, address] : *added_ids) {
-        id_to_address_.emplace(id, address);
-      }
-    }
-    size_t total() const { return address_to_workload_.size(); }
-    // Returns by-value since the flat map does not provide pointer stability.
-    std::optional<Istio::Common::WorkloadMetadataObject> get(const std::string& address) {
-      const auto it = address_to_workload_.find(address);
-      if (it != address_to_workload_.end()) {
-        return it->second;
-      }
-      return {};
-    }
-    IdToAddress id_to_address_;
-    AddressToWorkload address_to_workload_;
+    WorkloadIndexConstSharedPtr index_{std::make_shared<const WorkloadIndex>()};
   };
   class WorkloadSubscription : Config::SubscriptionBase<istio::workload::Workload> {
   public:
@@ -163,40 +245,37 @@ private:
     // Config::SubscriptionCallbacks
     absl::Status onConfigUpdate(const std::vector<Config::DecodedResourceRef>& resources,
                                 const std::string&) override {
-      AddressToWorkloadSharedPtr index = std::make_shared<AddressToWorkload>();
-      for (const auto& resource : resources) {
-        const auto& workload =
-            dynamic_cast<const istio::workload::Workload&>(resource.get().resource());
-        const auto& metadata = convert(workload);
-        for (const auto& addr : workload.addresses()) {
-          index->emplace(addr, metadata);
-        }
-      }
-      parent_.reset(index);
+      parent_.updater_.reset(entries(resources));
+      parent_.publish();
       return absl::OkStatus();
     }
     absl::Status onConfigUpdate(const std::vector<Config::DecodedResourceRef>& added_resources,
                                 const Protobuf::RepeatedPtrField<std::string>& removed_resources,
                                 const std::string&) override {
-      IdToAddressSharedPtr added_ids = std::make_shared<IdToAddress>();
-      AddressToWorkloadSharedPtr added_addresses = std::make_shared<AddressToWorkload>();
-      for (const auto& resource : added_resources) {
+      const std::vector<std::string> removed(removed_resources.begin(), removed_resources.end());
+      parent_.updater_.update(entries(added_resources), removed);
+      parent_.publish();
+      return absl::OkStatus();
+    }
+    static std::vector<WorkloadEntry>
+    entries(const std::vector<Config::DecodedResourceRef>& resources) {
+      std::vector<WorkloadEntry> entries;
+      entries.reserve(resources.size());
+      for (const auto& resource : resources) {
         const auto& workload =
             dynamic_cast<const istio::workload::Workload&>(resource.get().resource());
-        const auto& metadata = convert(workload);
+        // Converted once for all the addresses, e.g. of the dual-stack pods.
+        auto& entry = entries.emplace_back();
+        entry.uid_ = workload.uid();
+        entry.workload_ =
+            std::make_shared<const Istio::Common::WorkloadMetadataObject>(convert(workload));
         for (const auto& addr : workload.addresses()) {
-          added_addresses->emplace(addr, metadata);
+          if (const auto key = AddressKey::fromBytes(addr); key) {
+            entry.addresses_.push_back(*key);
+          }
         }
-        added_ids->emplace(workload.uid(), std::vector<std::string>(workload.addresses().begin(),
-                                                                    workload.addresses().end()));
-      }
-      auto removed = std::make_shared<std::vector<std::string>>();
-      removed->reserve(removed_resources.size());
-      for (const auto& resource : removed_resources) {
-        removed->push_back(resource);
       }
-      parent_.update(added_addresses, added_ids, removed);
-      return absl::OkStatus();
+      return entries;
     }
     void onConfigUpdateFailed(Config::ConfigUpdateFailureReason, const EnvoyException*) override {
       // Do nothing - feature is automatically disabled.
@@ -206,18 +285,10 @@ private:
     Config::SubscriptionPtr subscription_;
   };
 
-  void reset(AddressToWorkloadSharedPtr index) {
-    tls_.runOnAllThreads([index](OptRef<ThreadLocalProvider> tls) { tls->reset(index); });
-    stats_.total_.set(tls_->total());
-  }
-
-  void update(const AddressToWorkloadSharedPtr& added_addresses,
-              const IdToAddressSharedPtr& added_ids,
-              const std::shared_ptr<std::vector<std::string>> removed) {
-    tls_.runOnAllThreads([added_addresses, added_ids, removed](OptRef<ThreadLocalProvider> tls) {
-      tls->update(added_addresses, added_ids, removed);
-    });
-    stats_.total_.set(tls_->total());
+  void publish() {
+    const WorkloadIndexConstSharedPtr index = updater_.index();
+    tls_.runOnAllThreads([index](OptRef<ThreadLocalProvider> tls) { tls->index_ = index; });
+    stats_.total_.set(index->size());
   }
 
   WorkloadDiscoveryStats generateStats(Stats::Scope& scope) {
@@ -229,6 +300,8 @@ private:
   ThreadLocal::TypedSlot<ThreadLocalProvider> tls_;
   Stats::ScopeSharedPtr scope_;
   WorkloadDiscoveryStats stats_;
+  // Main thread only.
+  WorkloadIndexUpdater updater_;
   WorkloadSubscription subscription_;
 };
 
@@ -14,11 +14,19 @@
 
 #pragma once
 
+#include <array>
+#include <limits>
+#include <optional>
+
 #include "envoy/network/address.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/server/factory_context.h"
 #include "extensions/common/metadata_object.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/numeric/int128.h"
+
 namespace Envoy::Extensions::Common::WorkloadDiscovery {
 
 #define WORKLOAD_DISCOVERY_STATS(GAUGE) GAUGE(total, NeverImport)
@@ -27,10 +35,122 @@ struct WorkloadDiscoveryStats {
   WORKLOAD_DISCOVERY_STATS(GENERATE_GAUGE_STRUCT)
 };
 
+using Istio::Common::WorkloadMetadataObjectConstSharedPtr;
+
+// Fixed width key of an IP address, in the layout of the Envoy IP address
+// values. The IPv4-mapped IPv6 addresses are keyed as their IPv4 addresses.
+struct AddressKey {
+  static AddressKey ipv4(uint32_t address) { return {false, address}; }
+  static AddressKey ipv6(absl::uint128 address);
+  // Converts the 4 or 16 address bytes in network order.
+  static std::optional<AddressKey> fromBytes(absl::string_view bytes);
+  static std::optional<AddressKey> fromAddress(const Network::Address::Instance& address);
+
+  bool operator==(const AddressKey& other) const {
+    return ipv6_ == other.ipv6_ && address_ == other.address_;
+  }
+  template <typename H> friend H AbslHashValue(H h, const AddressKey& key) {
+    return H::combine(std::move(h), key.ipv6_, key.address_);
+  }
+
+  bool ipv6_;
+  absl::uint128 address_;
+};
+
+// Immutable address index, split into copy-on-write shards. A delta copies
+// only the shards it changes, and shares the rest with the previous index.
+class WorkloadIndex {
+public:
+  static constexpr size_t NumShards = 256;
+  using Shard = absl::flat_hash_map<AddressKey, WorkloadMetadataObjectConstSharedPtr>;
+  using ShardConstSharedPtr = std::shared_ptr<const Shard>;
+
+  WorkloadIndex();
+
+  // Returns the workload of the address, or nullptr if it is not known.
+  WorkloadMetadataObjectConstSharedPtr get(const AddressKey& address) const {
+    const auto& shard = *shards_[shardOf(address)];
+    const auto it = shard.find(address);
+    if (it != shard.end()) {
+      return it->second;
+    }
+    return nullptr;
+  }
+  size_t size() const { return size_; }
+
+  // Builds the next index on the main thread.
+  class Builder {
+  public:
+    explicit Builder(const WorkloadIndex& base) : index_(base) {}
+    void erase(const AddressKey& address);
+    // Inserts the workload of the address, or replaces it.
+    void assign(const AddressKey& address, const WorkloadMetadataObjectConstSharedPtr& workload);
+    WorkloadMetadataObjectConstSharedPtr get(const AddressKey& address) const {
+      return index_.get(address);
+    }
+    std::shared_ptr<const WorkloadIndex> build() {
+      return std::make_shared<const WorkloadIndex>(std::move(index_));
+    }
+
+  private:
+    Shard& mutableShard(size_t id);
+
+    WorkloadIndex index_;
+    // Shards already copied from the base index.
+    std::array<std::shared_ptr<Shard>, NumShards> copied_;
+  };
+
+private:
+  // Uses the top bits of the hash. The shard maps take their H2 control
+  // bytes from the low bits, which would otherwise be equal within a shard.
+  static size_t shardOf(const AddressKey& address) {
+    return (absl::HashOf(address) >> (std::numeric_limits<size_t>::digits - 8)) % NumShards;
+  }
+
+  std::array<ShardConstSharedPtr, NumShards> shards_;
+  size_t size_{0};
+};
+
+using WorkloadIndexConstSharedPtr = std::shared_ptr<const WorkloadIndex>;
+
+// A workload resource, by its unique ID. The workload is converted once, and
+// all its addresses map to the same instance in the index.
+struct WorkloadEntry {
+  std::string uid_;
+  WorkloadMetadataObjectConstSharedPtr workload_;
+  std::vector<AddressKey> addresses_;
+};
+
+// Applies the workload discovery updates to the index on the main thread, and
+// keeps track of the addresses of every workload to apply the removals.
+class WorkloadIndexUpdater {
+public:
+  const WorkloadIndexConstSharedPtr& index() const { return index_; }
+  // Replaces all workloads.
+  void reset(const std::vector<WorkloadEntry>& workloads);
+  // Adds or replaces the added workloads, and removes the removed workloads.
+  void update(const std::vector<WorkloadEntry>& added, const std::vector<std::string>& removed);
+
+private:
+  struct Addresses {
+    WorkloadMetadataObjectConstSharedPtr workload_;
+    std::vector<AddressKey> addresses_;
+  };
+  // Removes the addresses still pointing to the workload of the ID, since
+  // another workload may have taken over some of them.
+  void erase(WorkloadIndex::Builder& builder, const std::string& uid);
+  void insert(WorkloadIndex::Builder& builder, const WorkloadEntry& entry);
+
+  WorkloadIndexConstSharedPtr index_{std::make_shared<const WorkloadIndex>()};
+  absl::flat_hash_map<std::string, Addresses> id_to_address_;
+};
+
 class WorkloadMetadataProvider {
 public:
   virtual ~WorkloadMetadataProvider() = default;
-  virtual std::optional<Istio::Common::WorkloadMetadataObject>
+  // Returns the workload of the address, or nullptr if it is not known. The
+  // workload is shared with the index, and stays valid after index updates.
+  virtual WorkloadMetadataObjectConstSharedPtr
   GetMetadata(const Network::Address::InstanceConstSharedPtr& address) PURE;
 };
 
@@ -0,0 +1,198 @@
+// Copyright Istio Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/extensions/common/workload_discovery/api.h"
+
+#include "source/common/network/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy::Extensions::Common::WorkloadDiscovery {
+namespace {
+
+AddressKey key(const std::string& address) {
+  const auto instance = Network::Utility::parseInternetAddressNoThrow(address);
+  EXPECT_NE(nullptr, instance);
+  return AddressKey::fromAddress(*instance).value();
+}
+
+WorkloadMetadataObjectConstSharedPtr workload(absl::string_view name) {
+  return std::make_shared<const Istio::Common::WorkloadMetadataObject>(
+      name, "cluster", "default", name, name, "v1", name, "v1",
+      Istio::Common::WorkloadType::Pod, "spiffe://cluster.local/ns/default/sa/default");
+}
+
+WorkloadEntry entry(const std::string& uid, std::vector<std::string> addresses) {
+  WorkloadEntry entry{uid, workload(uid), {}};
+  for (const auto& address : addresses) {
+    entry.addresses_.push_back(key(address));
+  }
+  return entry;
+}
+
+TEST(AddressKeyTest, FromBytes) {
+  EXPECT_EQ(key("10.0.0.1"), AddressKey::fromBytes(std::string("\x0a\x00\x00\x01", 4)));
+  EXPECT_EQ(key("2001:db8::1"),
+            AddressKey::fromBytes(std::string(
+                "\x20\x01\x0d\xb8\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01", 16)));
+  EXPECT_FALSE(AddressKey::fromBytes("").has_value());
+  EXPECT_FALSE(AddressKey::fromBytes("10.0.0.1").has_value());
+}
+
+TEST(AddressKeyTest, Families) {
+  EXPECT_FALSE(key("10.0.0.1").ipv6_);
+  EXPECT_TRUE(key("2001:db8::1").ipv6_);
+  // Same value in the low bits, different families.
+  EXPECT_NE(key("10.0.0.1"), key("::a00:1"));
+  EXPECT_NE(key("0.0.0.0"), key("::"));
+}
+
+TEST(AddressKeyTest, Ipv4Mapped) {
+  EXPECT_EQ(key("10.0.0.1"), key("::ffff:10.0.0.1"));
+  EXPECT_FALSE(key("::ffff:10.0.0.1").ipv6_);
+  EXPECT_EQ(key("10.0.0.1"),
+            AddressKey::fromBytes(std::string(
+                "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xff\xff\x0a\x00\x00\x01", 16)));
+  // Not mapped, only close to it.
+  EXPECT_TRUE(key("::fffe:10.0.0.1").ipv6_);
+  EXPECT_TRUE(key("1::ffff:10.0.0.1").ipv6_);
+}
+
+TEST(WorkloadIndexTest, Miss) {
+  WorkloadIndexUpdater updater;
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.0.0.1")));
+  EXPECT_EQ(0U, updater.index()->size());
+
+  updater.reset({entry("a", {"10.0.0.1"})});
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.0.0.2")));
+  EXPECT_EQ(nullptr, updater.index()->get(key("::a00:1")));
+}
+
+TEST(WorkloadIndexTest, Reset) {
+  WorkloadIndexUpdater updater;
+  updater.reset({entry("a", {"10.0.0.1", "2001:db8::1"}), entry("b", {"10.0.0.2"})});
+  const auto a = updater.index()->get(key("10.0.0.1"));
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ("a", a->instance_name_);
+  EXPECT_EQ("b", updater.index()->get(key("10.0.0.2"))->instance_name_);
+  EXPECT_EQ(3U, updater.index()->size());
+
+  updater.reset({entry("b", {"10.0.0.2"})});
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.0.0.1")));
+  EXPECT_EQ(1U, updater.index()->size());
+}
+
+TEST(WorkloadIndexTest, SharedWorkload) {
+  WorkloadIndexUpdater updater;
+  const auto dual_stack = entry("a", {"10.0.0.1", "2001:db8::1", "10.1.0.1"});
+  updater.update({dual_stack}, {});
+  // The addresses of a workload share one instance, without copies.
+  EXPECT_EQ(dual_stack.workload_, updater.index()->get(key("10.0.0.1")));
+  EXPECT_EQ(dual_stack.workload_, updater.index()->get(key("2001:db8::1")));
+  EXPECT_EQ(dual_stack.workload_, updater.index()->get(key("10.1.0.1")));
+  EXPECT_EQ(3U, updater.index()->size());
+
+  // The removal releases all the addresses of the workload.
+  updater.update({}, {"a"});
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.0.0.1")));
+  EXPECT_EQ(nullptr, updater.index()->get(key("2001:db8::1")));
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.1.0.1")));
+  EXPECT_EQ(0U, updater.index()->size());
+  EXPECT_EQ(1, dual_stack.workload_.use_count());
+}
+
+TEST(WorkloadIndexTest, AddAcrossShards) {
+  WorkloadIndexUpdater updater;
+  std::vector<WorkloadEntry> added;
+  for (int i = 0; i < 1000; i++) {
+    added.push_back(entry(absl::StrCat("w", i), {absl::StrCat("10.0.", i / 256, ".", i % 256)}));
+  }
+  updater.update(added, {});
+  EXPECT_EQ(1000U, updater.index()->size());
+  for (int i = 0; i < 1000; i++) {
+    const auto found = updater.index()->get(key(absl::StrCat("10.0.", i / 256, ".", i % 256)));
+    ASSERT_NE(nullptr, found);
+    EXPECT_EQ(absl::StrCat("w", i), found->instance_name_);
+  }
+}
+
+TEST(WorkloadIndexTest, Update) {
+  WorkloadIndexUpdater updater;
+  updater.update({entry("a", {"10.0.0.1", "10.0.0.2"})}, {});
+  // The workload moves to another address.
+  updater.update({entry("a", {"10.0.0.2", "10.0.0.3"})}, {});
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.0.0.1")));
+  EXPECT_EQ("a", updater.index()->get(key("10.0.0.2"))->instance_name_);
+  EXPECT_EQ("a", updater.index()->get(key("10.0.0.3"))->instance_name_);
+  EXPECT_EQ(2U, updater.index()->size());
+}
+
+TEST(WorkloadIndexTest, Remove) {
+  WorkloadIndexUpdater updater;
+  updater.update({entry("a", {"10.0.0.1", "2001:db8::1"}), entry("b", {"10.0.0.2"})}, {});
+  updater.update({}, {"a", "unknown"});
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.0.0.1")));
+  EXPECT_EQ(nullptr, updater.index()->get(key("2001:db8::1")));
+  EXPECT_EQ("b", updater.index()->get(key("10.0.0.2"))->instance_name_);
+  EXPECT_EQ(1U, updater.index()->size());
+
+  // Removed and added back in the same delta.
+  updater.update({entry("b", {"10.0.0.3"})}, {"b"});
+  EXPECT_EQ(nullptr, updater.index()->get(key("10.0.0.2")));
+  EXPECT_EQ("b", updater.index()->get(key("10.0.0.3"))->instance_name_);
+  EXPECT_EQ(1U, updater.index()->size());
+}
+
+TEST(WorkloadIndexTest, RemoveKeepsTakenOverAddress) {
+  WorkloadIndexUpdater updater;
+  updater.update({entry("a", {"10.0.0.1"})}, {});
+  // The address is reused by another workload before the removal of the first.
+  updater.update({entry("b", {"10.0.0.1"})}, {});
+  updater.update({}, {"a"});
+  const auto found = updater.index()->get(key("10.0.0.1"));
+  ASSERT_NE(nullptr, found);
+  EXPECT_EQ("b", found->instance_name_);
+  EXPECT_EQ(1U, updater.index()->size());
+}
+
+TEST(WorkloadIndexTest, SnapshotUnchanged) {
+  WorkloadIndexUpdater updater;
+  updater.update({entry("a", {"10.0.0.1"}), entry("b", {"10.0.0.2"})}, {});
+  const WorkloadIndexConstSharedPtr snapshot = updater.index();
+  const auto a = snapshot->get(key("10.0.0.1"));
+
+  updater.update({entry("a", {"10.0.0.3"}), entry("c", {"10.0.0.4"})}, {"b"});
+  EXPECT_NE(snapshot, updater.index());
+  EXPECT_EQ(a, snapshot->get(key("10.0.0.1")));
+  EXPECT_EQ("b", snapshot->get(key("10.0.0.2"))->instance_name_);
+  EXPECT_EQ(nullptr, snapshot->get(key("10.0.0.3")));
+  EXPECT_EQ(nullptr, snapshot->get(key("10.0.0.4")));
+  EXPECT_EQ(2U, snapshot->size());
+  EXPECT_EQ(2U, updater.index()->size());
+}
+
+TEST(WorkloadIndexTest, HandleIdentity) {
+  WorkloadIndexUpdater updater;
+  updater.update({entry("a", {"10.0.0.1"}), entry("b", {"10.0.0.2"})}, {});
+  const auto a = updater.index()->get(key("10.0.0.1"));
+  for (int i = 0; i < 10; i++) {
+    updater.update({entry(absl::StrCat("c", i), {absl::StrCat("10.0.1.", i)})}, {"b"});
+  }
+  // The unrelated deltas keep the instance of the workload.
+  EXPECT_EQ(a, updater.index()->get(key("10.0.0.1")));
+  EXPECT_EQ(a, updater.index()->get(key("::ffff:10.0.0.1")));
+}
+
+} // namespace
+} // namespace Envoy::Extensions::Common::WorkloadDiscovery
@@ -15,6 +15,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "source/common/config/metadata.h"
 #include "source/common/network/application_protocol.h"
 #include "source/extensions/filters/http/alpn/alpn_filter.h"
 #include "test/mocks/http/mocks.h"
@@ -174,11 +175,13 @@ TEST_F(AlpnFilterTest, AlpnOverrideFalse) {
           istio:
             alpn_override: "false"
       )EOF");
+  const Config::TypedMetadataImpl<Upstream::ClusterTypedMetadataFactory> typed_metadata(metadata);
 
   ON_CALL(callbacks_, streamInfo()).WillByDefault(ReturnRef(stream_info));
   ON_CALL(cluster_manager_, getThreadLocalCluster(_)).WillByDefault(Return(fake_cluster_.get()));
   ON_CALL(*fake_cluster_, info()).WillByDefault(Return(cluster_info_));
   ON_CALL(*cluster_info_, metadata()).WillByDefault(ReturnRef(metadata));
+  ON_CALL(*cluster_info_, typedMetadata()).WillByDefault(ReturnRef(typed_metadata));
 
   const AlpnOverrides alpn = {{Http::Protocol::Http10, {"foo", "bar"}},
                               {Http::Protocol::Http11, {"baz"}}};
@@ -14,18 +14,28 @@
 
 #include "source/extensions/filters/http/istio_stats/istio_stats.h"
 
+#include <array>
 #include <atomic>
+#include <list>
 
 #include "envoy/router/string_accessor.h"
 #include "envoy/registry/registry.h"
 #include "envoy/server/factory_context.h"
 #include "envoy/singleton/manager.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+#include "extensions/common/cluster_metadata.h"
+#include "extensions/common/host_metadata.h"
 #include "extensions/common/metadata_object.h"
 #include "parser/parser.h"
+#include "source/common/common/hash.h"
+#include "source/common/common/lock_guard.h"
+#include "source/common/common/thread.h"
 #include "source/common/grpc/common.h"
 #include "source/common/http/header_map_impl.h"
 #include "source/common/http/header_utility.h"
 #include "source/common/network/utility.h"
+#include "source/common/stream_info/stream_info_impl.h"
 #include "source/common/stream_info/utility.h"
 #include "source/extensions/filters/common/expr/context.h"
 #include "source/extensions/filters/common/expr/cel_state.h"
@@ -33,6 +43,8 @@
 #include "source/extensions/filters/http/common/pass_through_filter.h"
 #include "source/extensions/filters/http/grpc_stats/grpc_stats_filter.h"
 
+#include "absl/strings/strip.h"
+
 #if defined(__GNUC__)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -70,6 +82,18 @@ absl::optional<absl::string_view> getNamespace(absl::string_view principal) {
 
 constexpr absl::string_view CustomStatNamespace = "istiocustom";
 
+// Bounds of the pre-interned response code and gRPC status tag values.
+constexpr uint32_t MaxResponseCode = 599;
+constexpr uint32_t MaxGrpcStatus = 16;
+
+// Pre-interned response flag combinations, in addition to the single flags.
+constexpr absl::string_view CommonResponseFlags[] = {
+    "UF,URX",
+    "UC,URX",
+    "UR,URX",
+    "UT,URX",
+};
+
 absl::string_view extractString(const ProtobufWkt::Struct& metadata, absl::string_view key) {
   const auto& it = metadata.fields().find(key);
   if (it == metadata.fields().end()) {
@@ -87,21 +111,16 @@ absl::string_view extractMapString(const ProtobufWkt::Struct& metadata, const st
   return extractString(it->second.struct_value(), key);
 }
 
-absl::optional<Istio::Common::WorkloadMetadataObject>
-extractEndpointMetadata(const StreamInfo::StreamInfo& info) {
+// Returns the peer workload decoded from the upstream host metadata.
+Istio::Common::HostMetadataConstSharedPtr
+extractEndpointMetadata(const Istio::Common::HostMetadataCache& cache,
+                        const StreamInfo::StreamInfo& info) {
   auto upstream_info = info.upstreamInfo();
   auto upstream_host = upstream_info ? upstream_info->upstreamHost() : nullptr;
-  if (upstream_host && upstream_host->metadata()) {
-    const auto& filter_metadata = upstream_host->metadata()->filter_metadata();
-    const auto& it = filter_metadata.find("istio");
-    if (it != filter_metadata.end()) {
-      const auto& workload_it = it->second.fields().find("workload");
-      if (workload_it != it->second.fields().end()) {
-        return Istio::Common::convertEndpointMetadata(workload_it->second.string_value());
-      }
-    }
+  if (upstream_host) {
+    return cache.lookup(*upstream_host);
   }
-  return {};
+  return nullptr;
 }
 
 enum class Reporter {
@@ -113,38 +132,64 @@ enum class Reporter {
   ServerGateway,
 };
 
+// Layout of the tags describing the local workload, which are emitted as one
+// block by the client and server sidecars. The block is pre-built in the
+// context, with the fallback values in the slots depending on the stream.
+template <Reporter R> struct LocalTagBlock;
+
+// The source_* tags of the client sidecar.
+template <> struct LocalTagBlock<Reporter::ClientSidecar> {
+  static constexpr size_t Principal = 4;
+  static constexpr size_t Size = 8;
+};
+
+// The destination_* tags of the server sidecar.
+template <> struct LocalTagBlock<Reporter::ServerSidecar> {
+  static constexpr size_t Principal = 2;
+  static constexpr size_t Service = 5;
+  static constexpr size_t ServiceName = 8;
+  static constexpr size_t Size = 11;
+};
+
 // Detect if peer info read is completed by TCP metadata exchange.
 bool peerInfoRead(Reporter reporter, const StreamInfo::FilterState& filter_state) {
-  const auto& filter_state_key =
-      reporter == Reporter::ServerSidecar || reporter == Reporter::ServerGateway
-          ? Istio::Common::DownstreamPeer
-          : Istio::Common::UpstreamPeer;
-  return filter_state.hasDataWithName(filter_state_key) ||
+  const bool downstream =
+      reporter == Reporter::ServerSidecar || reporter == Reporter::ServerGateway;
+  // The CEL state is skipped if the exchange only stores the typed object.
+  return filter_state.hasDataWithName(downstream ? Istio::Common::DownstreamPeerObject
+                                                 : Istio::Common::UpstreamPeerObject) ||
+         filter_state.hasDataWithName(downstream ? Istio::Common::DownstreamPeer
+                                                 : Istio::Common::UpstreamPeer) ||
          filter_state.hasDataWithName(Istio::Common::NoPeer);
 }
 
-std::optional<Istio::Common::WorkloadMetadataObject>
+// Returns the peer metadata object from the filter state. Falls back to
+// parsing the CelState when the typed object is missing.
+Istio::Common::WorkloadMetadataObjectConstSharedPtr
 peerInfo(Reporter reporter, const StreamInfo::FilterState& filter_state) {
-  const auto& filter_state_key =
-      reporter == Reporter::ServerSidecar || reporter == Reporter::ServerGateway
-          ? Istio::Common::DownstreamPeer
-          : Istio::Common::UpstreamPeer;
+  const bool downstream =
+      reporter == Reporter::ServerSidecar || reporter == Reporter::ServerGateway;
+  const auto* object = filter_state.getDataReadOnly<Istio::Common::WorkloadMetadataHandle>(
+      downstream ? Istio::Common::DownstreamPeerObject : Istio::Common::UpstreamPeerObject);
+  if (object) {
+    return object->workload();
+  }
   // This's a workaround before FilterStateObject support operation like `.labels['role']`.
   // The workaround is to use CelState to store the peer metadata.
   // Rebuild the WorkloadMetadataObject from the CelState.
   const auto* cel_state =
       filter_state.getDataReadOnly<Envoy::Extensions::Filters::Common::Expr::CelState>(
-          filter_state_key);
+          downstream ? Istio::Common::DownstreamPeer : Istio::Common::UpstreamPeer);
   if (!cel_state) {
-    return {};
+    return nullptr;
   }
 
   ProtobufWkt::Struct obj;
   if (!obj.ParseFromString(absl::string_view(cel_state->value()))) {
-    return {};
+    return nullptr;
   }
 
-  Istio::Common::WorkloadMetadataObject peer_info(
+  return std::make_shared<const Istio::Common::WorkloadMetadataObject>(
       extractString(obj, Istio::Common::InstanceNameToken),
       extractString(obj, Istio::Common::ClusterNameToken),
       extractString(obj, Istio::Common::NamespaceNameToken),
@@ -155,8 +200,6 @@ peerInfo(Reporter reporter, const StreamInfo::FilterState& filter_state) {
       extractString(obj, Istio::Common::AppVersionToken),
       Istio::Common::fromSuffix(extractString(obj, Istio::Common::WorkloadTypeToken)),
       extractString(obj, Istio::Common::IdentityToken));
-
-  return peer_info;
 }
 
 // Process-wide context shared with all filter instances.
@@ -178,6 +221,7 @@ struct Context : public Singleton::Instance {
         destination_(pool_.add("destination")), latest_(pool_.add("latest")),
         http_(pool_.add("http")), grpc_(pool_.add("grpc")), tcp_(pool_.add("tcp")),
         mutual_tls_(pool_.add("mutual_tls")), none_(pool_.add("none")),
+        no_response_flags_(pool_.add("-")), overflow_(pool_.add("__overflow__")),
         reporter_(pool_.add("reporter")), source_workload_(pool_.add("source_workload")),
         source_workload_namespace_(pool_.add("source_workload_namespace")),
         source_principal_(pool_.add("source_principal")), source_app_(pool_.add("source_app")),
@@ -201,6 +245,7 @@ struct Context : public Singleton::Instance {
         connection_security_policy_(pool_.add("connection_security_policy")),
         response_code_(pool_.add("response_code")),
         grpc_response_status_(pool_.add("grpc_response_status")),
+        sampling_denominator_(pool_.add("sampling_denominator")),
         workload_name_(pool_.add(extractString(local_info.node().metadata(), "WORKLOAD_NAME"))),
         namespace_(pool_.add(extractString(local_info.node().metadata(), "NAMESPACE"))),
         canonical_name_(pool_.add(extractMapString(local_info.node().metadata(), "LABELS",
@@ -254,12 +299,171 @@ struct Context : public Singleton::Instance {
         {"response_code", response_code_},
         {"grpc_response_status", grpc_response_status_},
     };
+    // Must match the order in which the filter populates the tags.
+    const std::vector<Stats::StatName> peer_layout = {
+        reporter_,
+        source_workload_,
+        source_canonical_service_,
+        source_canonical_revision_,
+        source_workload_namespace_,
+        source_principal_,
+        source_app_,
+        source_version_,
+        source_cluster_,
+        destination_workload_,
+        destination_workload_namespace_,
+        destination_principal_,
+        destination_app_,
+        destination_version_,
+        destination_service_,
+        destination_canonical_service_,
+        destination_canonical_revision_,
+        destination_service_name_,
+        destination_service_namespace_,
+        destination_cluster_,
+    };
+    std::vector<Stats::StatName> http_layout = peer_layout;
+    http_layout.insert(http_layout.end(), {request_protocol_, response_code_, grpc_response_status_,
+                                           response_flags_, connection_security_policy_});
+    std::vector<Stats::StatName> tcp_layout = peer_layout;
+    tcp_layout.insert(tcp_layout.end(),
+                      {request_protocol_, response_flags_, connection_security_policy_});
+    client_local_tags_ = {{
+        {source_workload_, workload_name_},
+        {source_canonical_service_, canonical_name_},
+        {source_canonical_revision_, canonical_revision_},
+        {source_workload_namespace_, namespace_},
+        {source_principal_, unknown_},
+        {source_app_, app_name_},
+        {source_version_, app_version_},
+        {source_cluster_, cluster_name_},
+    }};
+    server_local_tags_ = {{
+        {destination_workload_, workload_name_},
+        {destination_workload_namespace_, namespace_},
+        {destination_principal_, unknown_},
+        {destination_app_, app_name_},
+        {destination_version_, app_version_},
+        {destination_service_, canonical_name_},
+        {destination_canonical_service_, canonical_name_},
+        {destination_canonical_revision_, canonical_revision_},
+        {destination_service_name_, canonical_name_},
+        {destination_service_namespace_, namespace_},
+        {destination_cluster_, cluster_name_},
+    }};
+    http_metrics_ = {requests_total_, request_duration_milliseconds_, request_bytes_,
+                     response_bytes_};
+    grpc_metrics_ = http_metrics_;
+    grpc_metrics_.insert(grpc_metrics_.end(), {request_messages_total_, response_messages_total_});
+    tcp_metrics_ = {tcp_connections_opened_total_, tcp_connections_closed_total_,
+                    tcp_sent_bytes_total_, tcp_received_bytes_total_};
+    tag_layouts_ = {
+        {requests_total_, http_layout},
+        {request_duration_milliseconds_, http_layout},
+        {request_bytes_, http_layout},
+        {response_bytes_, http_layout},
+        {request_messages_total_, peer_layout},
+        {response_messages_total_, peer_layout},
+        {tcp_connections_opened_total_, tcp_layout},
+        {tcp_connections_closed_total_, tcp_layout},
+        {tcp_sent_bytes_total_, tcp_layout},
+        {tcp_received_bytes_total_, tcp_layout},
+    };
+    response_code_values_.reserve(MaxResponseCode + 1);
+    for (uint32_t code = 0; code <= MaxResponseCode; code++) {
+      response_code_values_.push_back(pool_.add(absl::StrCat(code)));
+    }
+    grpc_status_values_.reserve(MaxGrpcStatus + 1);
+    for (uint32_t status = 0; status <= MaxGrpcStatus; status++) {
+      grpc_status_values_.push_back(pool_.add(absl::StrCat(status)));
+    }
+    for (const auto& flag : StreamInfo::ResponseFlagUtils::responseFlagsVec()) {
+      symbolic_values_.emplace(flag.short_string_, pool_.add(flag.short_string_));
+    }
+    for (absl::string_view flags : CommonResponseFlags) {
+      symbolic_values_.emplace(flags, pool_.add(flags));
+    }
+    for (const Stats::StatName value :
+         {empty_, unknown_, source_, destination_, latest_, http_, grpc_, tcp_, mutual_tls_, none_,
+          no_response_flags_, overflow_, workload_name_, namespace_, canonical_name_,
+          canonical_revision_, app_name_, app_version_, cluster_name_, waypoint_, proxy_,
+          istio_version_}) {
+      symbolic_values_.emplace(symbol_table.toString(value), value);
+    }
+    for (const auto& values : {response_code_values_, grpc_status_values_}) {
+      for (const Stats::StatName value : values) {
+        symbolic_values_.emplace(symbol_table.toString(value), value);
+      }
+    }
+  }
+
+  // Returns the stat name of a tag value derived from the stream. The values
+  // with a pre-interned symbolic name resolve to it, all other values are
+  // encoded dynamically, so that equal values always have the same encoding
+  // and thus the same series.
+  Stats::StatName tagValue(absl::string_view value, Stats::StatNameDynamicPool& pool) const {
+    const auto it = symbolic_values_.find(value);
+    if (it != symbolic_values_.end()) {
+      return it->second;
+    }
+    return pool.add(value);
+  }
+
+  // Tag values for the response code, gRPC status, and response flags are
+  // looked up in the pre-interned tables, falling back to the stream pool
+  // only for the values outside of the known domains.
+  Stats::StatName responseCode(uint32_t code, Stats::StatNameDynamicPool& pool) const {
+    if (code <= MaxResponseCode) {
+      return response_code_values_[code];
+    }
+    return tagValue(absl::StrCat(code), pool);
+  }
+  Stats::StatName grpcStatus(Grpc::Status::GrpcStatus status,
+                             Stats::StatNameDynamicPool& pool) const {
+    if (status >= 0 && status <= MaxGrpcStatus) {
+      return grpc_status_values_[status];
+    }
+    return tagValue(absl::StrCat(status), pool);
+  }
+  Stats::StatName responseFlags(const StreamInfo::StreamInfo& info,
+                                Stats::StatNameDynamicPool& pool) const {
+    if (!info.hasAnyResponseFlag()) {
+      return no_response_flags_;
+    }
+    return tagValue(StreamInfo::ResponseFlagUtils::toShortString(info), pool);
+  }
+
+  template <Reporter R>
+  const std::array<Stats::StatNameTag, LocalTagBlock<R>::Size>& localTags() const {
+    if constexpr (R == Reporter::ClientSidecar) {
+      return client_local_tags_;
+    } else {
+      static_assert(R == Reporter::ServerSidecar);
+      return server_local_tags_;
+    }
   }
 
   Stats::StatNamePool pool_;
   const LocalInfo::LocalInfo& local_info_;
   absl::flat_hash_map<std::string, Stats::StatName> all_metrics_;
   absl::flat_hash_map<std::string, Stats::StatName> all_tags_;
+  // Tag names of the standard metrics, in the order they are emitted.
+  absl::flat_hash_map<Stats::StatName, std::vector<Stats::StatName>> tag_layouts_;
+  // Standard metrics reported by the HTTP, gRPC and TCP streams.
+  std::vector<Stats::StatName> http_metrics_;
+  std::vector<Stats::StatName> grpc_metrics_;
+  std::vector<Stats::StatName> tcp_metrics_;
+
+  // Pre-interned tag values.
+  std::vector<Stats::StatName> response_code_values_;
+  std::vector<Stats::StatName> grpc_status_values_;
+  // All the tag values with a symbolic name by their text, including the
+  // response flags.
+  absl::flat_hash_map<std::string, Stats::StatName> symbolic_values_;
+
+  // Local tag blocks of the sidecar reporters.
+  std::array<Stats::StatNameTag, LocalTagBlock<Reporter::ClientSidecar>::Size> client_local_tags_;
+  std::array<Stats::StatNameTag, LocalTagBlock<Reporter::ServerSidecar>::Size> server_local_tags_;
 
   // Metric names.
   const Stats::StatName stat_namespace_;
@@ -285,6 +489,8 @@ struct Context : public Singleton::Instance {
   const Stats::StatName tcp_;
   const Stats::StatName mutual_tls_;
   const Stats::StatName none_;
+  const Stats::StatName no_response_flags_;
+  const Stats::StatName overflow_;
 
   // Tag names.
   const Stats::StatName reporter_;
@@ -315,6 +521,7 @@ struct Context : public Singleton::Instance {
   const Stats::StatName connection_security_policy_;
   const Stats::StatName response_code_;
   const Stats::StatName grpc_response_status_;
+  const Stats::StatName sampling_denominator_;
 
   // Per-process constants.
   const Stats::StatName workload_name_;
@@ -342,13 +549,24 @@ using ContextSharedPtr = std::shared_ptr<Context>;
 SINGLETON_MANAGER_REGISTRATION(Context)
 
 // Instructions on dropping, creating, and overriding labels.
-// This is not the "hot path" of the metrics system and thus, fairly
-// unoptimized.
+// The transformations of each metric are compiled into a tag plan at
+// configuration time, and the expressions are evaluated once per stream:
+// - Expressions only referencing literals and the node metadata are folded
+//   into constants when the configuration is loaded.
+// - Expressions of the shapes listed in NativeExpression, e.g.
+//   request.headers['key'] or filter_state.upstream_peer.labels['key'], are
+//   read directly from the stream.
+// - All other expressions are evaluated by the CEL interpreter. So are the
+//   native ones when the stream holds a value only the interpreter can read,
+//   i.e. a CEL state or an object with field support under the filter state
+//   key, or a peer without the typed peer object.
 struct MetricOverrides : public Logger::Loggable<Logger::Id::filter> {
-  MetricOverrides(ContextSharedPtr& context, Stats::SymbolTable& symbol_table)
-      : context_(context), pool_(symbol_table) {}
+  MetricOverrides(ContextSharedPtr& context, Stats::SymbolTable& symbol_table,
+                  TimeSource& time_source)
+      : context_(context), pool_(symbol_table), time_source_(time_source) {}
   ContextSharedPtr context_;
   Stats::StatNameDynamicPool pool_;
+  TimeSource& time_source_;
 
   enum class MetricType {
     Counter,
@@ -365,6 +583,8 @@ struct MetricOverrides : public Logger::Loggable<Logger::Id::filter> {
   absl::flat_hash_map<std::string, CustomMetric> custom_metrics_;
   // Initial transformation: metrics dropped.
   absl::flat_hash_set<Stats::StatName> drop_;
+  // Metrics dropped when any of the predicates evaluates to true, by predicate id.
+  absl::flat_hash_map<Stats::StatName, std::vector<uint32_t>> drop_if_;
   // Second transformation: tags changed.
   using TagOverrides = absl::flat_hash_map<Stats::StatName, absl::optional<uint32_t>>;
   absl::flat_hash_map<Stats::StatName, TagOverrides> tag_overrides_;
@@ -372,34 +592,150 @@ struct MetricOverrides : public Logger::Loggable<Logger::Id::filter> {
   using TagAdditions = std::vector<std::pair<Stats::StatName, uint32_t>>;
   absl::flat_hash_map<Stats::StatName, TagAdditions> tag_additions_;
 
-  Stats::StatNameTagVector
-  overrideTags(Stats::StatName metric, const Stats::StatNameTagVector& tags,
-               const std::vector<std::pair<Stats::StatName, uint64_t>>& expr_values) {
-    Stats::StatNameTagVector out;
-    out.reserve(tags.size());
-    const auto& tag_overrides_it = tag_overrides_.find(metric);
-    if (tag_overrides_it == tag_overrides_.end()) {
-      out = tags;
-    } else
-      for (const auto& [key, val] : tags) {
-        const auto& it = tag_overrides_it->second.find(key);
-        if (it != tag_overrides_it->second.end()) {
-          if (it->second.has_value()) {
-            out.push_back({key, expr_values[it->second.value()].first});
-          } else {
-            // Skip dropped tags.
-          }
+  using ExprValues = std::vector<std::pair<Stats::StatName, uint64_t>>;
+
+  // All transformations of a metric compiled into a single pass over its
+  // standard tag layout.
+  struct TagPlan {
+    enum class Action : uint8_t {
+      Keep,
+      Drop,
+      Override,
+    };
+    struct Slot {
+      Stats::StatName tag_;
+      Action action_{Action::Keep};
+      uint32_t expr_{0};
+    };
+    bool drop_{false};
+    std::vector<uint32_t> drop_if_;
+    // Whether the tags are transformed, in addition to the drop conditions.
+    bool rewrite_{false};
+    // One slot per position in the standard tag layout of the metric.
+    std::vector<Slot> slots_;
+    // Fallback for the tags outside of the layout.
+    TagOverrides overrides_;
+    TagAdditions additions_;
+
+    void apply(const Stats::StatNameTagVector& tags, const ExprValues& expr_values,
+               Stats::StatNameTagVector& out) const {
+      out.clear();
+      for (size_t i = 0; i < tags.size(); i++) {
+        const auto& [key, val] = tags[i];
+        Action action = Action::Keep;
+        uint32_t expr = 0;
+        if (i < slots_.size() && slots_[i].tag_ == key) {
+          action = slots_[i].action_;
+          expr = slots_[i].expr_;
         } else {
+          const auto& it = overrides_.find(key);
+          if (it != overrides_.end()) {
+            action = it->second.has_value() ? Action::Override : Action::Drop;
+            expr = it->second.value_or(0);
+          }
+        }
+        switch (action) {
+        case Action::Keep:
           out.push_back({key, val});
+          break;
+        case Action::Override:
+          out.push_back({key, expr_values[expr].first});
+          break;
+        case Action::Drop:
+          break;
         }
       }
-    const auto& tag_additions_it = tag_additions_.find(metric);
-    if (tag_additions_it != tag_additions_.end()) {
-      for (const auto& [tag, id] : tag_additions_it->second) {
+      for (const auto& [tag, id] : additions_) {
         out.push_back({tag, expr_values[id].first});
       }
     }
-    return out;
+  };
+  absl::flat_hash_map<Stats::StatName, TagPlan> plans_;
+
+  // Compiles the transformations above into the per-metric plans.
+  void compile() {
+    for (const auto& metric : drop_) {
+      plans_[metric].drop_ = true;
+    }
+    for (auto& [metric, predicates] : drop_if_) {
+      plans_[metric].drop_if_ = std::move(predicates);
+    }
+    for (auto& [metric, overrides] : tag_overrides_) {
+      TagPlan& plan = plans_[metric];
+      plan.rewrite_ = true;
+      const auto& layout_it = context_->tag_layouts_.find(metric);
+      if (layout_it != context_->tag_layouts_.end()) {
+        plan.slots_.reserve(layout_it->second.size());
+        for (const auto& tag : layout_it->second) {
+          TagPlan::Slot slot{tag};
+          const auto& it = overrides.find(tag);
+          if (it != overrides.end()) {
+            slot.action_ =
+                it->second.has_value() ? TagPlan::Action::Override : TagPlan::Action::Drop;
+            slot.expr_ = it->second.value_or(0);
+          }
+          plan.slots_.push_back(slot);
+        }
+      }
+      plan.overrides_ = std::move(overrides);
+    }
+    for (auto& [metric, additions] : tag_additions_) {
+      TagPlan& plan = plans_[metric];
+      plan.rewrite_ = true;
+      plan.additions_ = std::move(additions);
+    }
+    drop_.clear();
+    drop_if_.clear();
+    tag_overrides_.clear();
+    tag_additions_.clear();
+  }
+  // Returns the plan of the metric, or nullptr if the metric is unchanged.
+  const TagPlan* plan(Stats::StatName metric) const {
+    const auto& it = plans_.find(metric);
+    return it != plans_.end() ? &it->second : nullptr;
+  }
+  // Converts the result of a value expression to a metric amount.
+  static uint64_t toAmount(const google::api::expr::runtime::CelValue& value) {
+    uint64_t result = 0;
+    switch (value.type()) {
+    case google::api::expr::runtime::CelValue::Type::kUint64:
+      return value.Uint64OrDie();
+    case google::api::expr::runtime::CelValue::Type::kInt64:
+      if (value.Int64OrDie() >= 0) {
+        return value.Int64OrDie();
+      }
+      break;
+    case google::api::expr::runtime::CelValue::Type::kString:
+      if (absl::SimpleAtoi(value.StringOrDie().value(), &result)) {
+        return result;
+      }
+      break;
+    default: {
+      const auto string_value = Filters::Common::Expr::print(value);
+      if (absl::SimpleAtoi(string_value, &result)) {
+        return result;
+      }
+      break;
+    }
+    }
+    ENVOY_LOG(trace, "Failed to get metric value: {}", Filters::Common::Expr::print(value));
+    return 0;
+  }
+  // Converts the result of a dimension expression to a tag value.
+  Stats::StatName toStatName(const google::api::expr::runtime::CelValue& value,
+                             Stats::StatNameDynamicPool& pool) const {
+    switch (value.type()) {
+    case google::api::expr::runtime::CelValue::Type::kString:
+      return context_->tagValue(value.StringOrDie().value(), pool);
+    case google::api::expr::runtime::CelValue::Type::kInt64:
+      return context_->tagValue(absl::StrCat(value.Int64OrDie()), pool);
+    case google::api::expr::runtime::CelValue::Type::kUint64:
+      return context_->tagValue(absl::StrCat(value.Uint64OrDie()), pool);
+    case google::api::expr::runtime::CelValue::Type::kBool:
+      return context_->tagValue(value.BoolOrDie() ? "true" : "false", pool);
+    default:
+      return context_->tagValue(Filters::Common::Expr::print(value), pool);
+    }
   }
   absl::optional<uint32_t> getOrCreateExpression(const std::string& expr, bool int_expr) {
     const auto& it = expression_ids_.find(expr);
@@ -410,6 +746,37 @@ struct MetricOverrides : public Logger::Loggable<Logger::Id::filter> {
     if (!parse_status.ok()) {
       return {};
     }
+    parsed_exprs_.push_back(parse_status.value().expr());
+    compiled_exprs_.push_back(std::make_pair(
+        Extensions::Filters::Common::Expr::createExpression(builder(), parsed_exprs_.back()),
+        int_expr));
+    folded_values_.emplace_back();
+    native_exprs_.emplace_back();
+    if (isConstant(parsed_exprs_.back())) {
+      folded_values_.back() = evaluateConstant(*compiled_exprs_.back().first, int_expr);
+      ENVOY_LOG(debug, "Folded constant expression: {}", expr);
+    } else {
+      native_exprs_.back() = matchNative(parsed_exprs_.back());
+      if (native_exprs_.back().has_value()) {
+        ENVOY_LOG(debug, "Native expression: {}", expr);
+      }
+    }
+    uint32_t id = compiled_exprs_.size() - 1;
+    expression_ids_.emplace(expr, id);
+    return {id};
+  }
+  // Compiles the predicate of a conditional drop, and returns its id.
+  absl::optional<uint32_t> createMatch(const std::string& expr) {
+    auto parse_status = google::api::expr::parser::Parse(expr);
+    if (!parse_status.ok()) {
+      return {};
+    }
+    parsed_matches_.push_back(parse_status.value().expr());
+    match_exprs_.push_back(
+        Extensions::Filters::Common::Expr::createExpression(builder(), parsed_matches_.back()));
+    return {static_cast<uint32_t>(match_exprs_.size() - 1)};
+  }
+  Filters::Common::Expr::Builder& builder() {
     if (expr_builder_ == nullptr) {
       google::api::expr::runtime::InterpreterOptions options;
       expr_builder_ = google::api::expr::runtime::CreateCelExpressionBuilder(options);
@@ -420,18 +787,323 @@ struct MetricOverrides : public Logger::Loggable<Logger::Id::filter> {
             absl::StrCat("failed to register built-in functions: ", register_status.message()));
       }
     }
-    parsed_exprs_.push_back(parse_status.value().expr());
-    compiled_exprs_.push_back(std::make_pair(
-        Extensions::Filters::Common::Expr::createExpression(*expr_builder_, parsed_exprs_.back()),
-        int_expr));
-    uint32_t id = compiled_exprs_.size() - 1;
-    expression_ids_.emplace(expr, id);
-    return {id};
+    return *expr_builder_;
+  }
+  // Returns true if the expression only references literals and the node
+  // metadata, and thus evaluates to the same value for every stream.
+  static bool isConstant(const google::api::expr::v1alpha1::Expr& expr) {
+    using google::api::expr::v1alpha1::Expr;
+    switch (expr.expr_kind_case()) {
+    case Expr::kConstExpr:
+      return true;
+    case Expr::kSelectExpr: {
+      const auto& select = expr.select_expr();
+      if (select.operand().has_ident_expr()) {
+        return select.operand().ident_expr().name() == "xds" && select.field() == "node";
+      }
+      return isConstant(select.operand());
+    }
+    case Expr::kCallExpr: {
+      const auto& call = expr.call_expr();
+      if (call.has_target() && !isConstant(call.target())) {
+        return false;
+      }
+      for (const auto& arg : call.args()) {
+        if (!isConstant(arg)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case Expr::kListExpr:
+      for (const auto& element : expr.list_expr().elements()) {
+        if (!isConstant(element)) {
+          return false;
+        }
+      }
+      return true;
+    case Expr::kStructExpr:
+      for (const auto& entry : expr.struct_expr().entries()) {
+        if ((entry.has_map_key() && !isConstant(entry.map_key())) || !isConstant(entry.value())) {
+          return false;
+        }
+      }
+      return true;
+    default:
+      // Identifiers and comprehensions are bound per stream.
+      return false;
+    }
+  }
+  // Expression of a common simple shape, which is evaluated with the native
+  // accessors instead of the interpreter.
+  struct NativeExpression {
+    enum class Source {
+      // request.headers['key']
+      RequestHeader,
+      // response.headers['key']
+      ResponseHeader,
+      // response.trailers['key']
+      ResponseTrailer,
+      // filter_state['key']
+      FilterState,
+      // filter_state.downstream_peer.labels['key']
+      DownstreamPeerLabel,
+      // filter_state.upstream_peer.labels['key']
+      UpstreamPeerLabel,
+    };
+    Source source_;
+    std::string key_;
+    Http::LowerCaseString header_;
+  };
+  static absl::optional<NativeExpression>
+  matchNative(const google::api::expr::v1alpha1::Expr& expr) {
+    using google::api::expr::v1alpha1::Expr;
+    // Matches `operand['key']` with a literal key, and `operand.key`.
+    const auto index = [](const Expr& expr, const Expr*& operand, std::string& key) {
+      if (expr.has_call_expr()) {
+        const auto& call = expr.call_expr();
+        if (call.function() != "_[_]" || call.has_target() || call.args_size() != 2 ||
+            !call.args(1).const_expr().has_string_value()) {
+          return false;
+        }
+        operand = &call.args(0);
+        key = call.args(1).const_expr().string_value();
+        return true;
+      }
+      if (expr.has_select_expr() && !expr.select_expr().test_only()) {
+        operand = &expr.select_expr().operand();
+        key = expr.select_expr().field();
+        return true;
+      }
+      return false;
+    };
+    const auto ident = [](const Expr* expr, absl::string_view name) {
+      return expr->has_ident_expr() && expr->ident_expr().name() == name;
+    };
+    const Expr* operand = nullptr;
+    std::string key;
+    if (!index(expr, operand, key)) {
+      return {};
+    }
+    if (ident(operand, "filter_state")) {
+      return NativeExpression{NativeExpression::Source::FilterState, key, Http::LowerCaseString()};
+    }
+    const Expr* root = nullptr;
+    std::string field;
+    if (!index(*operand, root, field)) {
+      return {};
+    }
+    if (ident(root, "request") && field == "headers") {
+      return NativeExpression{NativeExpression::Source::RequestHeader, key,
+                              Http::LowerCaseString(key)};
+    }
+    if (ident(root, "response") && (field == "headers" || field == "trailers")) {
+      return NativeExpression{field == "headers" ? NativeExpression::Source::ResponseHeader
+                                                 : NativeExpression::Source::ResponseTrailer,
+                              key, Http::LowerCaseString(key)};
+    }
+    const Expr* filter_state = nullptr;
+    std::string peer;
+    if (field != "labels" || !index(*root, filter_state, peer) ||
+        !ident(filter_state, "filter_state")) {
+      return {};
+    }
+    if (peer == Istio::Common::DownstreamPeer) {
+      return NativeExpression{NativeExpression::Source::DownstreamPeerLabel, key,
+                              Http::LowerCaseString()};
+    }
+    if (peer == Istio::Common::UpstreamPeer) {
+      return NativeExpression{NativeExpression::Source::UpstreamPeerLabel, key,
+                              Http::LowerCaseString()};
+    }
+    return {};
+  }
+  // Evaluates the native expression for the stream. Returns false if the
+  // stream needs the interpreter, e.g. when the filter state holds CEL state.
+  bool evaluateNative(const NativeExpression& native, bool int_expr,
+                      const StreamInfo::StreamInfo& info,
+                      const Http::RequestHeaderMap* request_headers,
+                      const Http::ResponseHeaderMap* response_headers,
+                      const Http::ResponseTrailerMap* response_trailers,
+                      Stats::StatNameDynamicPool& pool,
+                      std::pair<Stats::StatName, uint64_t>& value) const {
+    const auto set_value = [&](absl::optional<absl::string_view> result) {
+      if (!result.has_value()) {
+        value = {context_->unknown_, 0};
+      } else if (int_expr) {
+        uint64_t amount = 0;
+        if (!absl::SimpleAtoi(result.value(), &amount)) {
+          ENVOY_LOG(trace, "Failed to get metric value: {}", result.value());
+        }
+        value = {Stats::StatName(), amount};
+      } else {
+        value = {context_->tagValue(result.value(), pool), 0};
+      }
+    };
+    const auto set_header = [&](const Http::HeaderMap* headers) {
+      if (headers == nullptr) {
+        set_value({});
+        return;
+      }
+      const auto header = Http::HeaderUtility::getAllOfHeaderAsString(*headers, native.header_);
+      set_value(header.result());
+    };
+    switch (native.source_) {
+    case NativeExpression::Source::RequestHeader:
+      set_header(request_headers);
+      return true;
+    case NativeExpression::Source::ResponseHeader:
+      set_header(response_headers);
+      return true;
+    case NativeExpression::Source::ResponseTrailer:
+      set_header(response_trailers);
+      return true;
+    case NativeExpression::Source::FilterState: {
+      const auto* object = info.filterState().getDataReadOnlyGeneric(native.key_);
+      if (object == nullptr) {
+        set_value({});
+        return true;
+      }
+      if (dynamic_cast<const Filters::Common::Expr::CelState*>(object) != nullptr ||
+          object->hasFieldSupport()) {
+        return false;
+      }
+      const auto serialized = object->serializeAsString();
+      set_value(serialized.has_value() ? absl::make_optional<absl::string_view>(*serialized)
+                                       : absl::nullopt);
+      return true;
+    }
+    case NativeExpression::Source::DownstreamPeerLabel:
+    case NativeExpression::Source::UpstreamPeerLabel: {
+      const auto* peer = info.filterState().getDataReadOnly<Istio::Common::WorkloadMetadataHandle>(
+          native.source_ == NativeExpression::Source::DownstreamPeerLabel
+              ? Istio::Common::DownstreamPeerObject
+              : Istio::Common::UpstreamPeerObject);
+      if (peer == nullptr) {
+        return false;
+      }
+      set_value(peer->workload()->getLabel(native.key_));
+      return true;
+    }
+    }
+    return false;
+  }
+  std::pair<Stats::StatName, uint64_t>
+  evaluateConstant(const Filters::Common::Expr::Expression& expr, bool int_expr) {
+    Protobuf::Arena arena;
+    StreamInfo::StreamInfoImpl info(time_source_, nullptr,
+                                    StreamInfo::FilterState::LifeSpan::FilterChain);
+    const auto value = Filters::Common::Expr::evaluate(expr, arena, &context_->local_info_, info,
+                                                       nullptr, nullptr, nullptr);
+    if (!value.has_value() || value.value().IsError()) {
+      return {context_->unknown_, 0};
+    }
+    if (int_expr) {
+      return {Stats::StatName(), toAmount(value.value())};
+    }
+    return {toStatName(value.value(), pool_), 0};
   }
   Filters::Common::Expr::BuilderPtr expr_builder_;
   std::vector<google::api::expr::v1alpha1::Expr> parsed_exprs_;
   std::vector<std::pair<Filters::Common::Expr::ExpressionPtr, bool>> compiled_exprs_;
+  // Values of the expressions evaluated at configuration time, by expression id.
+  std::vector<absl::optional<std::pair<Stats::StatName, uint64_t>>> folded_values_;
+  // Native forms of the simple expressions, by expression id.
+  std::vector<absl::optional<NativeExpression>> native_exprs_;
   absl::flat_hash_map<std::string, uint32_t> expression_ids_;
+  // Predicates of the conditional drops, by predicate id. Only a boolean true
+  // drops the metrics.
+  std::vector<google::api::expr::v1alpha1::Expr> parsed_matches_;
+  std::vector<Filters::Common::Expr::ExpressionPtr> match_exprs_;
+};
+
+// Limits the number of distinct series per metric and in total. Consulted by
+// the workers on a series cache miss only. The series are partitioned into
+// stripes by their metric name, each with its own lock, and the total is
+// reserved atomically, so that the workers rarely contend. The series are
+// keyed by their decoded names, since the symbolic and dynamic encodings of
+// the same name differ.
+class SeriesBudget {
+public:
+  enum class Result {
+    Admitted,
+    // The series does not fit in the budget.
+    Rejected,
+    // Same, and the series was already rejected before.
+    RejectedAgain,
+  };
+
+  SeriesBudget(uint32_t max_per_metric, uint32_t max_total)
+      : max_per_metric_(max_per_metric), max_total_(max_total) {}
+  bool enabled() const { return max_per_metric_ > 0 || max_total_ > 0; }
+  Result admit(absl::string_view metric, const std::string& key) {
+    Stripe& stripe = stripes_[HashUtil::xxHash64(metric) % Stripes];
+    Thread::LockGuard lock(stripe.mutex_);
+    if (stripe.series_.contains(key)) {
+      return Result::Admitted;
+    }
+    const auto reject = [&stripe, &key] {
+      if (stripe.rejected_.size() >= MaxRejected) {
+        stripe.rejected_.clear();
+      }
+      return stripe.rejected_.insert(key).second ? Result::Rejected : Result::RejectedAgain;
+    };
+    const auto it = stripe.metric_series_.find(metric);
+    if (max_per_metric_ > 0 && it != stripe.metric_series_.end() &&
+        it->second >= max_per_metric_) {
+      return reject();
+    }
+    size_t total = total_.load();
+    do {
+      if (max_total_ > 0 && total >= max_total_) {
+        return reject();
+      }
+    } while (!total_.compare_exchange_weak(total, total + 1));
+    stripe.series_.insert(key);
+    stripe.rejected_.erase(key);
+    stripe.metric_series_[metric]++;
+    return Result::Admitted;
+  }
+  // Releases a series that expired.
+  void release(absl::string_view metric, const std::string& key) {
+    Stripe& stripe = stripes_[HashUtil::xxHash64(metric) % Stripes];
+    Thread::LockGuard lock(stripe.mutex_);
+    if (!stripe.series_.erase(key)) {
+      return;
+    }
+    total_--;
+    const auto it = stripe.metric_series_.find(metric);
+    if (it != stripe.metric_series_.end() && --it->second == 0) {
+      stripe.metric_series_.erase(it);
+    }
+  }
+  // Releases all series.
+  void clear() {
+    for (auto& stripe : stripes_) {
+      Thread::LockGuard lock(stripe.mutex_);
+      total_ -= stripe.series_.size();
+      stripe.series_.clear();
+      stripe.metric_series_.clear();
+    }
+  }
+
+private:
+  static constexpr size_t Stripes = 16;
+  // Upper bound on the rejected series remembered per stripe, to count each
+  // of them once in the overflow counter.
+  static constexpr size_t MaxRejected = 1000;
+
+  struct Stripe {
+    Thread::MutexBasicLockable mutex_;
+    absl::flat_hash_set<std::string> series_ ABSL_GUARDED_BY(mutex_);
+    absl::flat_hash_map<std::string, size_t> metric_series_ ABSL_GUARDED_BY(mutex_);
+    absl::flat_hash_set<std::string> rejected_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  const uint32_t max_per_metric_;
+  const uint32_t max_total_;
+  std::atomic<size_t> total_{0};
+  std::array<Stripe, Stripes> stripes_;
 };
 
 // Self-managed scope with active rotation. Envoy stats scope controls the
@@ -450,20 +1122,57 @@ struct MetricOverrides : public Logger::Loggable<Logger::Id::filter> {
 // 2. The implementation avoids locking by releasing a raw pointer to workers.
 // When the rotation happens on the main, the raw pointer may still be in-use
 // by workers for a short duration.
+//
+// With an idle timeout, the rotation only expires the idle metrics: the
+// metrics written within the timeout are carried over to the new scope before
+// the swap. The workers report a series as active on its first write after
+// every rotation. The allocator shares the metrics by name, so the carried
+// over metrics keep their values, and the workers keep their cached handles
+// of the carried over metrics across the rotation.
+//
+// The metrics can be partitioned by their series key into several scopes,
+// which are rotated in turns spread evenly over the rotation interval, so that
+// every rotation only recreates a fraction of the metrics.
+//
+// All scopes charge the series to a single budget, so that the limits are exact
+// regardless of how the series spread over the scopes, and release the series
+// as they expire.
 class RotatingScope : public Logger::Loggable<Logger::Id::filter> {
 public:
+  // Upper bound on the number of the scope shards.
+  static constexpr uint32_t MaxShards = 64;
+
+  // Metrics carried over by a rotation of a shard, published to the workers.
+  struct CarriedOver {
+    // Generation of the shard after the rotation.
+    uint64_t generation_;
+    absl::flat_hash_set<const Stats::Metric*> metrics_;
+  };
+  using CarriedOverConstSharedPtr = std::shared_ptr<const CarriedOver>;
+
   RotatingScope(Server::Configuration::FactoryContext& factory_context, uint64_t rotate_interval_ms,
-                uint64_t delete_interval_ms)
-      : parent_scope_(factory_context.scope()), active_scope_(parent_scope_.createScope("")),
-        raw_scope_(active_scope_.get()), rotate_interval_ms_(rotate_interval_ms),
-        delete_interval_ms_(delete_interval_ms) {
+                uint64_t delete_interval_ms, uint64_t idle_timeout_ms, uint32_t shards,
+                uint32_t max_series_per_metric, uint32_t max_series)
+      : parent_scope_(factory_context.scope()),
+        time_source_(factory_context.serverFactoryContext().timeSource()),
+        prefix_(parent_scope_.symbolTable().toString(parent_scope_.prefix())),
+        rotate_interval_ms_(rotate_interval_ms), delete_interval_ms_(delete_interval_ms),
+        idle_timeout_ms_(rotate_interval_ms > 0 ? idle_timeout_ms : 0),
+        budget_(max_series_per_metric, max_series) {
+    shards = std::clamp<uint32_t>(shards, 1, MaxShards);
+    for (uint32_t i = 0; i < shards; i++) {
+      shards_.push_back(std::make_unique<Shard>(parent_scope_.createScope("")));
+    }
     if (rotate_interval_ms_ > 0) {
       ASSERT(delete_interval_ms_ < rotate_interval_ms_);
       ASSERT(delete_interval_ms_ >= 1000);
       Event::Dispatcher& dispatcher = factory_context.serverFactoryContext().mainThreadDispatcher();
       rotate_timer_ = dispatcher.createTimer([this] { onRotate(); });
-      delete_timer_ = dispatcher.createTimer([this] { onDelete(); });
-      rotate_timer_->enableTimer(std::chrono::milliseconds(rotate_interval_ms_));
+      for (auto& shard : shards_) {
+        shard->delete_timer_ =
+            dispatcher.createTimer([this, target = shard.get()] { onDelete(*target); });
+      }
+      rotate_timer_->enableTimer(rotateTick());
     }
   }
   ~RotatingScope() {
@@ -471,34 +1180,513 @@ public:
       rotate_timer_->disableTimer();
       rotate_timer_.reset();
     }
-    if (delete_timer_) {
-      delete_timer_->disableTimer();
-      delete_timer_.reset();
+    for (auto& shard : shards_) {
+      if (shard->delete_timer_) {
+        shard->delete_timer_->disableTimer();
+        shard->delete_timer_.reset();
+      }
+    }
+  }
+  size_t shards() const { return shards_.size(); }
+  // Returns the shard of a series by its key.
+  size_t shard(absl::string_view key) const {
+    return shards_.size() == 1 ? 0 : HashUtil::xxHash64(key) % shards_.size();
+  }
+  Stats::Scope* scope(size_t shard) { return shards_[shard]->raw_scope_.load(); }
+  // Incremented after every rotation of the shard. Workers compare it to
+  // detect that the metric handles resolved from the previous scope must not
+  // be used anymore, except for the carried over metrics.
+  uint64_t generation(size_t shard) const { return shards_[shard]->generation_.load(); }
+  // Returns the metrics carried over by the last rotation of the shard, or
+  // null if the rotation expires all metrics.
+  CarriedOverConstSharedPtr carriedOver(size_t shard) {
+    Shard& target = *shards_[shard];
+    Thread::LockGuard lock(target.mutex_);
+    return target.carried_over_;
+  }
+  // Reports a metric of the shard as active in the current generation. Called
+  // by the workers once per series and rotation, so the lock is off the hot
+  // path.
+  void touch(size_t shard, const Stats::Metric& metric) {
+    if (idle_timeout_ms_ == 0) {
+      return;
+    }
+    Shard& target = *shards_[shard];
+    Thread::LockGuard lock(target.mutex_);
+    target.touched_.insert(&metric);
+  }
+  SeriesBudget& budget() { return budget_; }
+  // Returns the key of a series in the budget, given its name without the
+  // scope prefix.
+  std::string seriesKey(absl::string_view name, const Stats::StatNameTagVector& tags) const {
+    std::string key(name);
+    for (const auto& [tag, value] : tags) {
+      absl::StrAppend(&key, ";", symbolTable().toString(tag), "=", symbolTable().toString(value));
     }
+    return key;
   }
-  Stats::Scope* scope() { return raw_scope_.load(); }
+  Stats::SymbolTable& symbolTable() { return parent_scope_.symbolTable(); }
+  const Stats::SymbolTable& symbolTable() const { return parent_scope_.constSymbolTable(); }
+  bool rotating() const { return rotate_interval_ms_ > 0; }
+  uint64_t deleteIntervalMs() const { return delete_interval_ms_; }
 
 private:
+  struct Shard {
+    explicit Shard(Stats::ScopeSharedPtr scope)
+        : active_scope_(std::move(scope)), raw_scope_(active_scope_.get()) {}
+    Stats::ScopeSharedPtr active_scope_;
+    std::atomic<Stats::Scope*> raw_scope_;
+    std::atomic<uint64_t> generation_{0};
+    Stats::ScopeSharedPtr draining_scope_{nullptr};
+    // Unprefixed scopes owning the carried over metrics, which are re-created
+    // by their full names.
+    Stats::ScopeSharedPtr carried_scope_{nullptr};
+    Stats::ScopeSharedPtr draining_carried_scope_{nullptr};
+    Event::TimerPtr delete_timer_{nullptr};
+    // Last observed activity of the carried over metrics. Main thread only.
+    absl::flat_hash_map<const Stats::Metric*, MonotonicTime> activity_;
+    Thread::MutexBasicLockable mutex_;
+    // Metrics written by the workers since the last rotation.
+    absl::flat_hash_set<const Stats::Metric*> touched_ ABSL_GUARDED_BY(mutex_);
+    CarriedOverConstSharedPtr carried_over_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  std::chrono::milliseconds rotateTick() const {
+    return std::chrono::milliseconds(rotate_interval_ms_ / shards_.size());
+  }
   void onRotate() {
-    ENVOY_LOG(info, "Rotating active Istio stats scope after {}ms.", rotate_interval_ms_);
-    draining_scope_ = active_scope_;
-    delete_timer_->enableTimer(std::chrono::milliseconds(delete_interval_ms_));
-    active_scope_ = parent_scope_.createScope("");
-    raw_scope_.store(active_scope_.get());
-    rotate_timer_->enableTimer(std::chrono::milliseconds(rotate_interval_ms_));
-  }
-  void onDelete() {
+    Shard& shard = *shards_[next_shard_];
+    ENVOY_LOG(info, "Rotating active Istio stats scope {}/{} after {}ms.", next_shard_ + 1,
+              shards_.size(), rotate_interval_ms_);
+    Stats::ScopeSharedPtr scope = parent_scope_.createScope("");
+    Stats::ScopeSharedPtr carried_scope;
+    if (idle_timeout_ms_ > 0) {
+      carried_scope = parent_scope_.store().rootScope()->createScope("");
+      carryOver(shard, *carried_scope, shard.generation_.load() + 1);
+    } else if (shards_.size() == 1) {
+      budget_.clear();
+    } else {
+      releaseAll(shard);
+    }
+    shard.draining_scope_ = shard.active_scope_;
+    shard.draining_carried_scope_ = shard.carried_scope_;
+    shard.delete_timer_->enableTimer(std::chrono::milliseconds(delete_interval_ms_));
+    shard.active_scope_ = scope;
+    shard.carried_scope_ = carried_scope;
+    shard.raw_scope_.store(shard.active_scope_.get());
+    shard.generation_++;
+    next_shard_ = (next_shard_ + 1) % shards_.size();
+    rotate_timer_->enableTimer(rotateTick());
+  }
+  void onDelete(Shard& shard) {
     ENVOY_LOG(info, "Deleting draining Istio stats scope after {}ms.", delete_interval_ms_);
-    draining_scope_.reset();
+    shard.draining_scope_.reset();
+    shard.draining_carried_scope_.reset();
+  }
+  // Re-creates the metrics of the shard written within the idle timeout in
+  // the carried over scope, and publishes them for the next generation.
+  void carryOver(Shard& shard, Stats::Scope& scope, uint64_t generation) {
+    const MonotonicTime now = time_source_.monotonicTime();
+    absl::flat_hash_set<const Stats::Metric*> touched;
+    {
+      Thread::LockGuard lock(shard.mutex_);
+      touched.swap(shard.touched_);
+    }
+    auto carried_over = std::make_shared<CarriedOver>();
+    carried_over->generation_ = generation;
+    absl::flat_hash_map<const Stats::Metric*, MonotonicTime> activity;
+    size_t expired = 0;
+    const auto active = [&](const Stats::Metric& metric) {
+      if (carried_over->metrics_.contains(&metric)) {
+        // Already visited in the other scope.
+        return false;
+      }
+      MonotonicTime written = now;
+      const auto it = shard.activity_.find(&metric);
+      if (it != shard.activity_.end() && !touched.contains(&metric)) {
+        written = it->second;
+      }
+      if (now - written >= std::chrono::milliseconds(idle_timeout_ms_)) {
+        expired++;
+        release(metric);
+        return false;
+      }
+      carried_over->metrics_.insert(&metric);
+      activity.emplace(&metric, written);
+      return true;
+    };
+    for (Stats::Scope* source : {shard.active_scope_.get(), shard.carried_scope_.get()}) {
+      if (source == nullptr) {
+        continue;
+      }
+      source->iterate(Stats::IterateFn<Stats::Counter>(
+          [&](const Stats::CounterSharedPtr& counter) -> bool {
+            if (active(*counter)) {
+              scope.counterFromStatNameWithTags(counter->tagExtractedStatName(), tags(*counter));
+            }
+            return true;
+          }));
+      source->iterate(
+          Stats::IterateFn<Stats::Gauge>([&](const Stats::GaugeSharedPtr& gauge) -> bool {
+            if (active(*gauge)) {
+              scope.gaugeFromStatNameWithTags(gauge->tagExtractedStatName(), tags(*gauge),
+                                              gauge->importMode());
+            }
+            return true;
+          }));
+      source->iterate(Stats::IterateFn<Stats::Histogram>(
+          [&](const Stats::HistogramSharedPtr& histogram) -> bool {
+            if (active(*histogram)) {
+              scope.histogramFromStatNameWithTags(histogram->tagExtractedStatName(),
+                                                  tags(*histogram), histogram->unit());
+            }
+            return true;
+          }));
+    }
+    ENVOY_LOG(info, "Carried over {} Istio metrics, expired {} idle metrics.", activity.size(),
+              expired);
+    shard.activity_ = std::move(activity);
+    Thread::LockGuard lock(shard.mutex_);
+    shard.carried_over_ = std::move(carried_over);
   }
+  // Releases the budget of all series of the shard, which expire together.
+  void releaseAll(Shard& shard) {
+    if (!budget_.enabled()) {
+      return;
+    }
+    Stats::Scope& scope = *shard.active_scope_;
+    scope.iterate(
+        Stats::IterateFn<Stats::Counter>([&](const Stats::CounterSharedPtr& counter) -> bool {
+          release(*counter);
+          return true;
+        }));
+    scope.iterate(Stats::IterateFn<Stats::Gauge>([&](const Stats::GaugeSharedPtr& gauge) -> bool {
+      release(*gauge);
+      return true;
+    }));
+    scope.iterate(Stats::IterateFn<Stats::Histogram>(
+        [&](const Stats::HistogramSharedPtr& histogram) -> bool {
+          release(*histogram);
+          return true;
+        }));
+  }
+  // Releases the budget of an expired series.
+  void release(const Stats::Metric& metric) {
+    if (!budget_.enabled()) {
+      return;
+    }
+    const std::string tag_extracted_name = metric.tagExtractedName();
+    absl::string_view name = tag_extracted_name;
+    if (!prefix_.empty()) {
+      absl::ConsumePrefix(&name, prefix_);
+      absl::ConsumePrefix(&name, ".");
+    }
+    budget_.release(name, seriesKey(name, tags(metric)));
+  }
+  static Stats::StatNameTagVector tags(const Stats::Metric& metric) {
+    Stats::StatNameTagVector tags;
+    metric.iterateTagStatNames([&tags](Stats::StatName name, Stats::StatName value) -> bool {
+      tags.emplace_back(name, value);
+      return true;
+    });
+    return tags;
+  }
+
   Stats::Scope& parent_scope_;
-  Stats::ScopeSharedPtr active_scope_;
-  std::atomic<Stats::Scope*> raw_scope_;
-  Stats::ScopeSharedPtr draining_scope_{nullptr};
+  TimeSource& time_source_;
+  const std::string prefix_;
   const uint64_t rotate_interval_ms_;
   const uint64_t delete_interval_ms_;
+  const uint64_t idle_timeout_ms_;
+  // Budget of the series of all shards.
+  SeriesBudget budget_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // Next shard to rotate. Main thread only.
+  size_t next_shard_{0};
   Event::TimerPtr rotate_timer_{nullptr};
-  Event::TimerPtr delete_timer_{nullptr};
+};
+
+// Per-worker cache of the metric handles resolved from the active scope, keyed
+// by the encoded metric name and its final tags. The tag values are resolved
+// through Context::tagValue or the name cache, which give each value a single
+// encoding, so the key and the scope shard of a series do not depend on where
+// its values came from. Steady-state requests skip the tag join and the scope
+// lookup entirely. The handles are owned by the scope, so the cache of a scope
+// shard is dropped as soon as it is rotated, except for the handles of the
+// carried over metrics.
+struct SeriesCache {
+  // Upper bound on the cached series per worker and scope shard.
+  static constexpr size_t MaxSize = 10000;
+
+  template <class T> struct Entry {
+    T* metric_;
+    // Set on every use, and cleared by the eviction sweep.
+    bool used_;
+    // Whether the use was reported to the scope in the current generation.
+    bool touched_;
+    // Whether the series was rejected by the budget and resolved to the
+    // overflow series.
+    bool overflow_;
+  };
+  template <class T> using Map = absl::flat_hash_map<std::string, Entry<T>>;
+
+  struct Shard {
+    void clear() {
+      counters_.clear();
+      gauges_.clear();
+      histograms_.clear();
+    }
+    // Keeps the handles of the metrics carried over to the next generation.
+    void retain(const absl::flat_hash_set<const Stats::Metric*>& metrics) {
+      retain(counters_, metrics);
+      retain(gauges_, metrics);
+      retain(histograms_, metrics);
+    }
+
+    // Generation of the scope that owns the cached handles.
+    uint64_t generation_{0};
+    Map<Stats::Counter> counters_;
+    Map<Stats::Gauge> gauges_;
+    Map<Stats::Histogram> histograms_;
+
+  private:
+    template <class T>
+    static void retain(Map<T>& cache, const absl::flat_hash_set<const Stats::Metric*>& metrics) {
+      for (auto it = cache.begin(); it != cache.end();) {
+        // The rejected series are admitted again after the rotation, which
+        // may have released some of the budget.
+        if (it->second.overflow_ || !metrics.contains(it->second.metric_)) {
+          cache.erase(it++);
+        } else {
+          it->second.touched_ = false;
+          ++it;
+        }
+      }
+    }
+  };
+
+  explicit SeriesCache(size_t shards) : shards_(shards) {}
+  void buildKey(Stats::StatName metric, const Stats::StatNameTagVector& tags) {
+    key_.clear();
+    appendKey(metric);
+    for (const auto& [name, value] : tags) {
+      appendKey(name);
+      appendKey(value);
+    }
+  }
+  // Returns the cached entry of the current lookup, if any.
+  template <class T> Entry<T>* find(Map<T>& cache) {
+    const auto it = cache.find(key_);
+    if (it == cache.end()) {
+      return nullptr;
+    }
+    it->second.used_ = true;
+    return &it->second;
+  }
+  template <class T> Entry<T>& insert(Map<T>& cache, T& metric) {
+    if (cache.size() >= MaxSize) {
+      evict(cache);
+    }
+    return cache.emplace(key_, Entry<T>{&metric, true, false, overflow_}).first->second;
+  }
+  Shard& shard() { return shards_[shard_]; }
+
+  // Scratch buffer holding the key of the current lookup.
+  std::string key_;
+  // Scope shard of the current lookup.
+  size_t shard_{0};
+  // Scratch buffer holding the tags of an overflow series.
+  Stats::StatNameTagVector overflow_tags_;
+  // Whether the current lookup resolved to the overflow series.
+  bool overflow_{false};
+  std::vector<Shard> shards_;
+
+private:
+  // Second chance eviction: drops the entries not used since the previous
+  // sweep, and clears the bit of the others. If all entries were used, the
+  // working set exceeds the cache and a quarter of the entries is dropped.
+  template <class T> static void evict(Map<T>& cache) {
+    for (auto it = cache.begin(); it != cache.end();) {
+      if (!it->second.used_) {
+        cache.erase(it++);
+      } else {
+        it->second.used_ = false;
+        ++it;
+      }
+    }
+    if (cache.size() >= MaxSize) {
+      cache.erase(cache.begin(), std::next(cache.begin(), MaxSize / 4));
+    }
+  }
+  void appendKey(Stats::StatName name) {
+    // Length-prefix the names to keep the concatenation unambiguous.
+    const uint32_t size = name.dataSize();
+    key_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    if (size > 0) {
+      key_.append(reinterpret_cast<const char*>(name.data()), size);
+    }
+  }
+};
+
+// Dynamic stat name shared by the tags that outlive the stream that encoded
+// it, e.g. the tags cached on the connection.
+using NameRef = std::shared_ptr<const Stats::StatNameDynamicStorage>;
+
+// Per-worker bounded cache of the stat names of the peer-derived tag values,
+// consulted before encoding a new name. The dynamic names are reference
+// counted: the owners of the tags hold on to their names, so evicting an entry
+// never invalidates a name that is still in use.
+struct NameCache {
+  // Upper bound on the cached names per worker.
+  static constexpr size_t MaxSize = 10000;
+  // Number of lookups accumulated locally before updating the shared counters.
+  static constexpr uint64_t StatsBatchSize = 1024;
+
+  struct Entry {
+    Stats::StatName stat_name_;
+    // Storage of the dynamic name, null if the value has a symbolic name.
+    NameRef name_;
+    // Set on every use, and cleared by the eviction sweep.
+    bool used_;
+  };
+
+  // Returns the cached name of the value, resolving it on a miss.
+  const Entry& get(absl::string_view value, const Context& context,
+                   Stats::SymbolTable& symbol_table) {
+    auto it = names_.find(value);
+    if (it != names_.end()) {
+      hits_++;
+      it->second.used_ = true;
+      return it->second;
+    }
+    misses_++;
+    if (names_.size() >= MaxSize) {
+      evict();
+    }
+    Entry entry{Stats::StatName(), nullptr, true};
+    const auto symbolic = context.symbolic_values_.find(value);
+    if (symbolic != context.symbolic_values_.end()) {
+      entry.stat_name_ = symbolic->second;
+    } else {
+      entry.name_ = std::make_shared<const Stats::StatNameDynamicStorage>(value, symbol_table);
+      entry.stat_name_ = entry.name_->statName();
+    }
+    return names_.emplace(std::string(value), std::move(entry)).first->second;
+  }
+
+  absl::flat_hash_map<std::string, Entry> names_;
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+
+private:
+  // Second chance eviction, as in the series cache.
+  void evict() {
+    for (auto it = names_.begin(); it != names_.end();) {
+      if (!it->second.used_) {
+        names_.erase(it++);
+      } else {
+        it->second.used_ = false;
+        ++it;
+      }
+    }
+    if (names_.size() >= MaxSize) {
+      names_.erase(names_.begin(), std::next(names_.begin(), MaxSize / 4));
+    }
+  }
+};
+
+// A stream or connection reporting its metrics periodically.
+class PeriodicReport {
+public:
+  virtual ~PeriodicReport() = default;
+  virtual void onReport() PURE;
+};
+
+// Per-worker wheel of the periodic reports. A single worker timer advances
+// over the buckets, so that each bucket is reported once per interval. The
+// reports join the bucket under the cursor, which spreads them over the
+// interval by their start time.
+class ReportWheel {
+public:
+  static constexpr size_t Buckets = 16;
+  using Handle = std::pair<size_t, std::list<PeriodicReport*>::iterator>;
+
+  void initialize(Event::Dispatcher& dispatcher, std::chrono::milliseconds interval) {
+    tick_ = std::max(interval / Buckets, std::chrono::milliseconds(1));
+    timer_ = dispatcher.createTimer([this] { onTick(); });
+  }
+  Handle add(PeriodicReport& report) {
+    auto& bucket = buckets_[cursor_];
+    bucket.push_front(&report);
+    if (size_++ == 0) {
+      timer_->enableTimer(tick_);
+    }
+    return {cursor_, bucket.begin()};
+  }
+  void remove(const Handle& handle) {
+    buckets_[handle.first].erase(handle.second);
+    size_--;
+  }
+
+private:
+  void onTick() {
+    cursor_ = (cursor_ + 1) % Buckets;
+    auto& bucket = buckets_[cursor_];
+    for (auto it = bucket.begin(); it != bucket.end();) {
+      // Advance first, since the report may remove itself.
+      PeriodicReport* report = *it++;
+      report->onReport();
+    }
+    if (size_ > 0) {
+      timer_->enableTimer(tick_);
+    }
+  }
+
+  std::array<std::list<PeriodicReport*>, Buckets> buckets_;
+  size_t cursor_{0};
+  size_t size_{0};
+  std::chrono::milliseconds tick_{0};
+  Event::TimerPtr timer_;
+};
+
+struct ThreadLocalState : public ThreadLocal::ThreadLocalObject {
+  explicit ThreadLocalState(size_t shards) : series_(shards) {}
+  ~ThreadLocalState() override { flush(); }
+  void flush() {
+    for (const auto& [_, pending] : pending_) {
+      pending.counter_->add(pending.amount_);
+    }
+    pending_.clear();
+  }
+
+  // Counter increment accumulated on the worker. Holds a reference to the
+  // counter, which may outlive its scope until the flush.
+  struct PendingIncrement {
+    Stats::CounterSharedPtr counter_;
+    uint64_t amount_{0};
+  };
+
+  SeriesCache series_;
+  NameCache names_;
+  // Counter increments accumulated on the worker until the next flush.
+  absl::flat_hash_map<Stats::Counter*, PendingIncrement> pending_;
+  Event::TimerPtr flush_timer_;
+  ReportWheel reports_;
+};
+
+/**
+ * All istio_stats filter stats. @see stats_macros.h
+ */
+#define ALL_ISTIO_STATS_FILTER_STATS(COUNTER)                                                      \
+  COUNTER(name_cache_hit)                                                                          \
+  COUNTER(name_cache_miss)                                                                         \
+  COUNTER(series_overflow)
+
+/**
+ * Struct definition for all istio_stats filter stats. @see stats_macros.h
+ */
+struct IstioStatsFilterStats {
+  ALL_ISTIO_STATS_FILTER_STATS(GENERATE_COUNTER_STRUCT)
 };
 
 struct Config : public Logger::Loggable<Logger::Id::filter> {
@@ -513,11 +1701,42 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
             })),
         scope_(factory_context, PROTOBUF_GET_MS_OR_DEFAULT(proto_config, rotation_interval, 0),
                PROTOBUF_GET_MS_OR_DEFAULT(proto_config, graceful_deletion_interval,
-                                          /* 5m */ 1000 * 60 * 5)),
+                                          /* 5m */ 1000 * 60 * 5),
+               PROTOBUF_GET_MS_OR_DEFAULT(proto_config, series_idle_timeout, 0),
+               proto_config.rotation_shards(), proto_config.max_series_per_metric(),
+               proto_config.max_series()),
         disable_host_header_fallback_(proto_config.disable_host_header_fallback()),
         report_duration_(
-            PROTOBUF_GET_MS_OR_DEFAULT(proto_config, tcp_reporting_duration, /* 5s */ 5000)) {
+            PROTOBUF_GET_MS_OR_DEFAULT(proto_config, tcp_reporting_duration, /* 5s */ 5000)),
+        histogram_sampling_denominator_(proto_config.histogram_sampling_denominator()),
+        flush_interval_(flushInterval(proto_config, scope_)),
+        host_metadata_(
+            Istio::Common::HostMetadataCache::get(factory_context.serverFactoryContext())),
+        stats_{ALL_ISTIO_STATS_FILTER_STATS(
+            POOL_COUNTER_PREFIX(factory_context.scope(), "istio_stats."))},
+        tls_(factory_context.serverFactoryContext().threadLocal()) {
+    tls_.set([shards = scope_.shards(), flush_interval = flush_interval_,
+              report_duration = report_duration_](Event::Dispatcher& dispatcher) {
+      auto state = std::make_shared<ThreadLocalState>(shards);
+      if (report_duration.count() > 0) {
+        state->reports_.initialize(dispatcher, report_duration);
+      }
+      if (flush_interval.count() > 0) {
+        state->flush_timer_ = dispatcher.createTimer([state = state.get(), flush_interval] {
+          state->flush();
+          state->flush_timer_->enableTimer(flush_interval);
+        });
+        state->flush_timer_->enableTimer(flush_interval);
+      }
+      return state;
+    });
     recordVersion(factory_context);
+    if (histogram_sampling_denominator_ > 1) {
+      histogram_sampling_value_.emplace(absl::StrCat(histogram_sampling_denominator_),
+                                        symbolTable());
+      histogram_sampling_tag_ = {context_->sampling_denominator_,
+                                 histogram_sampling_value_->statName()};
+    }
     reporter_ = Reporter::ClientSidecar;
     switch (proto_config.reporter()) {
     case stats::Reporter::UNSPECIFIED:
@@ -539,7 +1758,8 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
       break;
     }
     if (proto_config.metrics_size() > 0 || proto_config.definitions_size() > 0) {
-      metric_overrides_ = std::make_unique<MetricOverrides>(context_, scope()->symbolTable());
+      metric_overrides_ = std::make_unique<MetricOverrides>(
+          context_, symbolTable(), factory_context.serverFactoryContext().timeSource());
       for (const auto& definition : proto_config.definitions()) {
         const auto& it = context_->all_metrics_.find(definition.name());
         if (it != context_->all_metrics_.end()) {
@@ -570,11 +1790,25 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
       for (const auto& metric : proto_config.metrics()) {
         if (metric.drop()) {
           const auto& it = context_->all_metrics_.find(metric.name());
-          if (it != context_->all_metrics_.end()) {
+          if (it == context_->all_metrics_.end()) {
+            continue;
+          }
+          if (metric.match().empty()) {
             metric_overrides_->drop_.insert(it->second);
+            continue;
           }
+          auto id = metric_overrides_->createMatch(metric.match());
+          if (!id.has_value()) {
+            ENVOY_LOG(info, "Failed to parse match expression: {}", metric.match());
+            continue;
+          }
+          metric_overrides_->drop_if_[it->second].push_back(id.value());
           continue;
         }
+        if (!metric.match().empty()) {
+          ENVOY_LOG(info, "Match is only supported for dropping metrics, ignoring: {}",
+                    metric.match());
+        }
         for (const auto& tag : metric.tags_to_remove()) {
           const auto& tag_it = context_->all_tags_.find(tag);
           if (tag_it == context_->all_tags_.end()) {
@@ -651,6 +1885,7 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
           }
         }
       }
+      metric_overrides_->compile();
     }
   }
 
@@ -663,19 +1898,58 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
                   const Http::RequestHeaderMap* request_headers = nullptr,
                   const Http::ResponseHeaderMap* response_headers = nullptr,
                   const Http::ResponseTrailerMap* response_trailers = nullptr) {
+      evaluateMatches(info, request_headers, response_headers, response_trailers);
+      evaluateValues(info, request_headers, response_headers, response_trailers);
+    }
+
+    // Evaluates the drop predicates. Called before the tags are built, so that
+    // the streams dropping all their metrics skip that work.
+    void evaluateMatches(const StreamInfo::StreamInfo& info,
+                         const Http::RequestHeaderMap* request_headers = nullptr,
+                         const Http::ResponseHeaderMap* response_headers = nullptr,
+                         const Http::ResponseTrailerMap* response_trailers = nullptr) {
+      matched_.clear();
+      if (!parent_.metric_overrides_ || parent_.metric_overrides_->match_exprs_.empty()) {
+        return;
+      }
+      activate(info, request_headers, response_headers, response_trailers);
+      for (const auto& expr : parent_.metric_overrides_->match_exprs_) {
+        auto eval_status = expr->Evaluate(*this, &arena_);
+        // A predicate that fails to evaluate does not drop the metrics.
+        matched_.push_back(eval_status.ok() && eval_status.value().IsBool() &&
+                           eval_status.value().BoolOrDie());
+      }
+      arena_.Reset();
+      resetActivation();
+    }
+
+    // Evaluates the value and dimension expressions.
+    void evaluateValues(const StreamInfo::StreamInfo& info,
+                        const Http::RequestHeaderMap* request_headers = nullptr,
+                        const Http::ResponseHeaderMap* response_headers = nullptr,
+                        const Http::ResponseTrailerMap* response_trailers = nullptr) {
       evaluated_ = true;
       if (parent_.metric_overrides_) {
-        local_info_ = &parent_.context_->local_info_;
-        activation_info_ = &info;
-        activation_request_headers_ = request_headers;
-        activation_response_headers_ = response_headers;
-        activation_response_trailers_ = response_trailers;
+        activate(info, request_headers, response_headers, response_trailers);
         const auto& compiled_exprs = parent_.metric_overrides_->compiled_exprs_;
+        const auto& folded_values = parent_.metric_overrides_->folded_values_;
+        const auto& native_exprs = parent_.metric_overrides_->native_exprs_;
         expr_values_.clear();
         expr_values_.reserve(compiled_exprs.size());
         for (size_t id = 0; id < compiled_exprs.size(); id++) {
-          Protobuf::Arena arena;
-          auto eval_status = compiled_exprs[id].first->Evaluate(*this, &arena);
+          if (folded_values[id].has_value()) {
+            expr_values_.push_back(folded_values[id].value());
+            continue;
+          }
+          std::pair<Stats::StatName, uint64_t> value;
+          if (native_exprs[id].has_value() &&
+              parent_.metric_overrides_->evaluateNative(
+                  native_exprs[id].value(), compiled_exprs[id].second, info, request_headers,
+                  response_headers, response_trailers, pool_, value)) {
+            expr_values_.push_back(value);
+            continue;
+          }
+          auto eval_status = compiled_exprs[id].first->Evaluate(*this, &arena_);
           if (!eval_status.ok() || eval_status.value().IsError()) {
             if (!eval_status.ok()) {
               ENVOY_LOG(debug, "Failed to evaluate metric expression: {}", eval_status.status());
@@ -685,19 +1959,16 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
                         eval_status.value().ErrorOrDie()->message());
             }
             expr_values_.push_back(std::make_pair(parent_.context_->unknown_, 0));
+          } else if (compiled_exprs[id].second) {
+            expr_values_.push_back(
+                std::make_pair(Stats::StatName(), MetricOverrides::toAmount(eval_status.value())));
           } else {
-            const auto string_value = Filters::Common::Expr::print(eval_status.value());
-            if (compiled_exprs[id].second) {
-              uint64_t amount = 0;
-              if (!absl::SimpleAtoi(string_value, &amount)) {
-                ENVOY_LOG(trace, "Failed to get metric value: {}", string_value);
-              }
-              expr_values_.push_back(std::make_pair(Stats::StatName(), amount));
-            } else {
-              expr_values_.push_back(std::make_pair(pool_.add(string_value), 0));
-            }
+            expr_values_.push_back(std::make_pair(
+                parent_.metric_overrides_->toStatName(eval_status.value(), pool_), 0));
           }
         }
+        // The values are copied out, so the arena can be recycled for the next evaluation.
+        arena_.Reset();
         resetActivation();
       }
     }
@@ -705,62 +1976,42 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
     void addCounter(Stats::StatName metric, const Stats::StatNameTagVector& tags,
                     uint64_t amount = 1) {
       ASSERT(evaluated_);
-      if (parent_.metric_overrides_) {
-        if (parent_.metric_overrides_->drop_.contains(metric)) {
-          return;
-        }
-        auto new_tags = parent_.metric_overrides_->overrideTags(metric, tags, expr_values_);
-        Stats::Utility::counterFromStatNames(*parent_.scope(),
-                                             {parent_.context_->stat_namespace_, metric}, new_tags)
-            .add(amount);
-        return;
+      const auto* new_tags = overrideTags(metric, tags);
+      if (new_tags) {
+        parent_.add(parent_.counter(metric, *new_tags), amount);
       }
-      Stats::Utility::counterFromStatNames(*parent_.scope(),
-                                           {parent_.context_->stat_namespace_, metric}, tags)
-          .add(amount);
     }
 
     void recordHistogram(Stats::StatName metric, Stats::Histogram::Unit unit,
                          const Stats::StatNameTagVector& tags, uint64_t value) {
       ASSERT(evaluated_);
-      if (parent_.metric_overrides_) {
-        if (parent_.metric_overrides_->drop_.contains(metric)) {
-          return;
-        }
-        auto new_tags = parent_.metric_overrides_->overrideTags(metric, tags, expr_values_);
-        Stats::Utility::histogramFromStatNames(
-            *parent_.scope(), {parent_.context_->stat_namespace_, metric}, unit, new_tags)
-            .recordValue(value);
-        return;
+      const auto* new_tags = overrideTags(metric, tags);
+      if (new_tags) {
+        parent_.histogram(metric, unit, *new_tags).recordValue(value);
       }
-      Stats::Utility::histogramFromStatNames(
-          *parent_.scope(), {parent_.context_->stat_namespace_, metric}, unit, tags)
-          .recordValue(value);
     }
 
     void recordCustomMetrics() {
       ASSERT(evaluated_);
       if (parent_.metric_overrides_) {
+        const Stats::StatNameTagVector no_tags;
         for (const auto& [_, metric] : parent_.metric_overrides_->custom_metrics_) {
-          const auto tags = parent_.metric_overrides_->overrideTags(metric.name_, {}, expr_values_);
+          const auto* new_tags = overrideTags(metric.name_, no_tags);
+          if (!new_tags) {
+            continue;
+          }
+          const auto& tags = *new_tags;
           uint64_t amount = expr_values_[metric.expr_].second;
           switch (metric.type_) {
           case MetricOverrides::MetricType::Counter:
-            Stats::Utility::counterFromStatNames(
-                *parent_.scope(), {parent_.context_->stat_namespace_, metric.name_}, tags)
-                .add(amount);
+            parent_.add(parent_.counter(metric.name_, tags), amount);
             break;
           case MetricOverrides::MetricType::Histogram:
-            Stats::Utility::histogramFromStatNames(
-                *parent_.scope(), {parent_.context_->stat_namespace_, metric.name_},
-                Stats::Histogram::Unit::Bytes, tags)
+            parent_.histogram(metric.name_, Stats::Histogram::Unit::Bytes, tags)
                 .recordValue(amount);
             break;
           case MetricOverrides::MetricType::Gauge:
-            Stats::Utility::gaugeFromStatNames(*parent_.scope(),
-                                               {parent_.context_->stat_namespace_, metric.name_},
-                                               Stats::Gauge::ImportMode::Accumulate, tags)
-                .set(amount);
+            parent_.gauge(metric.name_, tags).set(amount);
             break;
           default:
             break;
@@ -769,9 +2020,71 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
       }
     }
 
+    // Returns true if the stream drops all of the given standard metrics, and
+    // has no custom metrics to report. Valid after the predicates are evaluated.
+    bool dropsAll(const std::vector<Stats::StatName>& metrics) const {
+      if (!parent_.metric_overrides_ || !parent_.metric_overrides_->custom_metrics_.empty()) {
+        return false;
+      }
+      for (const auto metric : metrics) {
+        const auto* plan = parent_.metric_overrides_->plan(metric);
+        if (plan == nullptr || !dropped(*plan)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Returns the tags after the overrides, or nullptr if the metric is dropped.
+    const Stats::StatNameTagVector* overrideTags(Stats::StatName metric,
+                                                 const Stats::StatNameTagVector& tags) {
+      if (!parent_.metric_overrides_) {
+        return &tags;
+      }
+      const auto* plan = parent_.metric_overrides_->plan(metric);
+      if (plan == nullptr) {
+        return &tags;
+      }
+      if (dropped(*plan)) {
+        return nullptr;
+      }
+      if (!plan->rewrite_) {
+        return &tags;
+      }
+      plan->apply(tags, expr_values_, tags_buffer_);
+      return &tags_buffer_;
+    }
+
+    bool dropped(const MetricOverrides::TagPlan& plan) const {
+      if (plan.drop_) {
+        return true;
+      }
+      for (const auto id : plan.drop_if_) {
+        if (id < matched_.size() && matched_[id]) {
+          return true;
+        }
+      }
+      return false;
+    }
+    void activate(const StreamInfo::StreamInfo& info, const Http::RequestHeaderMap* request_headers,
+                  const Http::ResponseHeaderMap* response_headers,
+                  const Http::ResponseTrailerMap* response_trailers) {
+      local_info_ = &parent_.context_->local_info_;
+      activation_info_ = &info;
+      activation_request_headers_ = request_headers;
+      activation_response_headers_ = response_headers;
+      activation_response_trailers_ = response_trailers;
+    }
+
     Config& parent_;
     Stats::StatNameDynamicPool& pool_;
-    std::vector<std::pair<Stats::StatName, uint64_t>> expr_values_;
+    // Results of the drop predicates, by predicate id.
+    std::vector<bool> matched_;
+    MetricOverrides::ExprValues expr_values_;
+    // Shared by all expressions of the stream and reset after every evaluation.
+    Protobuf::Arena arena_;
+    // Reused across metrics to hold the tags after the overrides.
+    Stats::StatNameTagVector tags_buffer_;
     bool evaluated_{false};
   };
 
@@ -788,7 +2101,154 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
   }
 
   Reporter reporter() const { return reporter_; }
-  Stats::Scope* scope() { return scope_.scope(); }
+  // Selects the streams recording the histograms, deterministically by the stream ID.
+  bool histogramSampled(const StreamInfo::StreamInfo& info) const {
+    if (histogram_sampling_denominator_ <= 1) {
+      return true;
+    }
+    const auto provider = info.getStreamIdProvider();
+    const auto id = provider.has_value() ? provider->toInteger() : absl::nullopt;
+    return !id.has_value() || id.value() % histogram_sampling_denominator_ == 0;
+  }
+  Stats::SymbolTable& symbolTable() { return scope_.symbolTable(); }
+  ReportWheel& reports() { return tls_->reports_; }
+
+  // Resolves the metric handles through the worker series cache.
+  // Increments the counter, or accumulates the increment on the worker.
+  void add(Stats::Counter& counter, uint64_t amount) {
+    if (flush_interval_.count() == 0) {
+      counter.add(amount);
+      return;
+    }
+    auto [it, inserted] = tls_->pending_.try_emplace(&counter);
+    if (inserted) {
+      it->second = {Stats::CounterSharedPtr(&counter), 0};
+    }
+    it->second.amount_ += amount;
+  }
+  static std::chrono::milliseconds flushInterval(const stats::PluginConfig& proto_config,
+                                                 const RotatingScope& scope) {
+    uint64_t flush_interval_ms = PROTOBUF_GET_MS_OR_DEFAULT(proto_config, worker_flush_interval, 0);
+    if (flush_interval_ms > 0 && scope.rotating()) {
+      // Flush the accumulated increments before the draining scope owning the
+      // counters is deleted, so that they are not only applied to counters
+      // already removed from the stats output.
+      flush_interval_ms = std::min(flush_interval_ms, scope.deleteIntervalMs() / 2);
+    }
+    return std::chrono::milliseconds(flush_interval_ms);
+  }
+  Stats::Counter& counter(Stats::StatName metric, const Stats::StatNameTagVector& tags) {
+    SeriesCache& cache = seriesCache(metric, tags);
+    auto& counters = cache.shard().counters_;
+    auto* entry = cache.find(counters);
+    if (entry == nullptr) {
+      auto& counter = Stats::Utility::counterFromStatNames(
+          *scope_.scope(cache.shard_), {context_->stat_namespace_, metric},
+          admit(metric, tags, cache));
+      entry = &cache.insert(counters, counter);
+    }
+    return touch(cache, *entry);
+  }
+  Stats::Gauge& gauge(Stats::StatName metric, const Stats::StatNameTagVector& tags) {
+    SeriesCache& cache = seriesCache(metric, tags);
+    auto& gauges = cache.shard().gauges_;
+    auto* entry = cache.find(gauges);
+    if (entry == nullptr) {
+      auto& gauge = Stats::Utility::gaugeFromStatNames(
+          *scope_.scope(cache.shard_), {context_->stat_namespace_, metric},
+          Stats::Gauge::ImportMode::Accumulate, admit(metric, tags, cache));
+      entry = &cache.insert(gauges, gauge);
+    }
+    return touch(cache, *entry);
+  }
+  Stats::Histogram& histogram(Stats::StatName metric, Stats::Histogram::Unit unit,
+                              const Stats::StatNameTagVector& tags) {
+    SeriesCache& cache = seriesCache(metric, tags);
+    auto& histograms = cache.shard().histograms_;
+    auto* entry = cache.find(histograms);
+    if (entry == nullptr) {
+      auto& histogram = Stats::Utility::histogramFromStatNames(
+          *scope_.scope(cache.shard_), {context_->stat_namespace_, metric}, unit,
+          admit(metric, tags, cache));
+      entry = &cache.insert(histograms, histogram);
+    }
+    return touch(cache, *entry);
+  }
+  // Reports the first use of a series in the current generation to the scope,
+  // which tracks the activity of the series on write.
+  template <class T> T& touch(SeriesCache& cache, SeriesCache::Entry<T>& entry) {
+    if (!entry.touched_) {
+      entry.touched_ = true;
+      scope_.touch(cache.shard_, *entry.metric_);
+    }
+    return *entry.metric_;
+  }
+  // Returns the tags of the series to use for a new series, which are the
+  // overflow tags if the series does not fit in the budget. The result is
+  // cached under the original key until the next rotation, so the budget is
+  // checked once per worker and rotation. Each rejected series is counted once.
+  const Stats::StatNameTagVector& admit(Stats::StatName metric,
+                                        const Stats::StatNameTagVector& tags, SeriesCache& cache) {
+    cache.overflow_ = false;
+    SeriesBudget& budget = scope_.budget();
+    if (!budget.enabled()) {
+      return tags;
+    }
+    const std::string name = absl::StrCat(symbolTable().toString(context_->stat_namespace_), ".",
+                                          symbolTable().toString(metric));
+    const auto result = budget.admit(name, scope_.seriesKey(name, tags));
+    if (result == SeriesBudget::Result::Admitted) {
+      return tags;
+    }
+    if (result == SeriesBudget::Result::Rejected) {
+      stats_.series_overflow_.inc();
+    }
+    cache.overflow_ = true;
+    cache.overflow_tags_.clear();
+    for (const auto& [name, _] : tags) {
+      cache.overflow_tags_.push_back({name, context_->overflow_});
+    }
+    return cache.overflow_tags_;
+  }
+  // Returns the stat name for a peer-derived tag value from the worker name
+  // cache, and keeps a reference to it in the owner of the tags.
+  Stats::StatName intern(absl::string_view value, std::vector<NameRef>& refs) {
+    NameCache& cache = tls_->names_;
+    const NameCache::Entry& entry = cache.get(value, *context_, symbolTable());
+    if (entry.name_) {
+      refs.push_back(entry.name_);
+    }
+    if (cache.hits_ + cache.misses_ >= NameCache::StatsBatchSize) {
+      stats_.name_cache_hit_.add(cache.hits_);
+      stats_.name_cache_miss_.add(cache.misses_);
+      cache.hits_ = 0;
+      cache.misses_ = 0;
+    }
+    return entry.stat_name_;
+  }
+
+  SeriesCache& seriesCache(Stats::StatName metric, const Stats::StatNameTagVector& tags) {
+    SeriesCache& cache = tls_->series_;
+    cache.buildKey(metric, tags);
+    cache.shard_ = scope_.shard(cache.key_);
+    // Read the generation before the scope so that handles from a new scope
+    // are at worst cached under the old generation and dropped on next use.
+    const uint64_t generation = scope_.generation(cache.shard_);
+    SeriesCache::Shard& shard = cache.shard();
+    if (shard.generation_ != generation) {
+      // Keep the handles of the carried over metrics if the cache holds the
+      // handles of the generation they were carried over from.
+      const auto carried_over = scope_.carriedOver(cache.shard_);
+      if (carried_over != nullptr && carried_over->generation_ == generation &&
+          shard.generation_ + 1 == generation) {
+        shard.retain(carried_over->metrics_);
+      } else {
+        shard.clear();
+      }
+      shard.generation_ = generation;
+    }
+    return cache;
+  }
 
   ContextSharedPtr context_;
   RotatingScope scope_;
@@ -796,19 +2256,66 @@ struct Config : public Logger::Loggable<Logger::Id::filter> {
 
   const bool disable_host_header_fallback_;
   const std::chrono::milliseconds report_duration_;
+  const uint32_t histogram_sampling_denominator_;
+  // Tag of the sampled histograms with the denominator, so that their counts
+  // can be scaled back. Set if the histograms are sampled.
+  absl::optional<Stats::StatNameManagedStorage> histogram_sampling_value_;
+  absl::optional<Stats::StatNameTag> histogram_sampling_tag_;
+  const std::chrono::milliseconds flush_interval_;
+  Istio::Common::HostMetadataCacheSharedPtr host_metadata_;
   std::unique_ptr<MetricOverrides> metric_overrides_;
+  IstioStatsFilterStats stats_;
+  ThreadLocal::TypedSlot<ThreadLocalState> tls_;
 };
 
 using ConfigSharedPtr = std::shared_ptr<Config>;
 
+// Filter state key to cache the server peer tags on the downstream connection.
+constexpr absl::string_view ServerPeerTagsKey = "io.istio.stats.server_peer_tags";
+
+// Tags derived from the downstream peer by the server reporters.
+struct ServerPeerTags : public StreamInfo::FilterState::Object {
+  // Whether the tags were derived from the same peer workload and principals.
+  bool matches(const Istio::Common::WorkloadMetadataObject* peer, absl::string_view peer_san,
+               absl::string_view local_san) const {
+    if (peer_san != peer_san_ || local_san != local_san_) {
+      return false;
+    }
+    if (peer == peer_.get()) {
+      return true;
+    }
+    if (!peer || !peer_) {
+      return false;
+    }
+    // The CEL state fallback parses a new object for every stream.
+    return peer->workload_name_ == peer_->workload_name_ &&
+           peer->namespace_name_ == peer_->namespace_name_ &&
+           peer->canonical_name_ == peer_->canonical_name_ &&
+           peer->canonical_revision_ == peer_->canonical_revision_ &&
+           peer->app_name_ == peer_->app_name_ && peer->app_version_ == peer_->app_version_ &&
+           peer->cluster_name_ == peer_->cluster_name_;
+  }
+
+  Istio::Common::WorkloadMetadataObjectConstSharedPtr peer_;
+  std::string peer_san_;
+  std::string local_san_;
+  bool mutual_tls_{false};
+  // The source_* tags, in order.
+  Stats::StatNameTagVector source_tags_;
+  Stats::StatName local_principal_;
+  // References to the cached peer-derived names used in the tags.
+  std::vector<NameRef> name_refs_;
+};
+
 class IstioStatsFilter : public Http::PassThroughFilter,
                          public Logger::Loggable<Logger::Id::filter>,
                          public AccessLog::Instance,
-                         public Network::ReadFilter,
-                         public Network::ConnectionCallbacks {
+                         public Network::Filter,
+                         public Network::ConnectionCallbacks,
+                         public PeriodicReport {
 public:
   IstioStatsFilter(ConfigSharedPtr config)
-      : config_(config), context_(*config->context_), pool_(config->scope()->symbolTable()),
+      : config_(config), context_(*config->context_), pool_(config->symbolTable()),
         stream_(*config_, pool_) {
     tags_.reserve(25);
     switch (config_->reporter()) {
@@ -823,14 +2330,19 @@ public:
       break;
     }
   }
-  ~IstioStatsFilter() { ASSERT(report_timer_ == nullptr); }
+  ~IstioStatsFilter() override {
+    // A stream may be destroyed without a final log or close event, e.g. when the filter chain is
+    // torn down early. Never leave a dangling filter in the report wheel.
+    if (report_handle_.has_value()) {
+      config_->reports().remove(report_handle_.value());
+    }
+  }
 
   // Http::StreamDecoderFilter
   Http::FilterHeadersStatus decodeHeaders(Http::RequestHeaderMap& request_headers, bool) override {
     is_grpc_ = Grpc::Common::isGrpcRequestHeaders(request_headers);
-    if (is_grpc_) {
-      report_timer_ = decoder_callbacks_->dispatcher().createTimer([this] { onReportTimer(); });
-      report_timer_->enableTimer(config_->report_duration_);
+    if (is_grpc_ && config_->report_duration_ > std::chrono::milliseconds(0)) {
+      report_handle_ = config_->reports().add(*this);
     }
     return Http::FilterHeadersStatus::Continue;
   }
@@ -842,6 +2354,16 @@ public:
     const Http::ResponseHeaderMap* response_headers = &log_context.responseHeaders();
     const Http::ResponseTrailerMap* response_trailers = &log_context.responseTrailers();
 
+    // Evaluate the drop predicates first, so that the requests dropping all
+    // their metrics, e.g. the health check probes, skip building the tags.
+    stream_.evaluateMatches(info, request_headers, response_headers, response_trailers);
+    if (stream_.dropsAll(is_grpc_ ? context_.grpc_metrics_ : context_.http_metrics_)) {
+      if (report_handle_.has_value()) {
+        config_->reports().remove(report_handle_.value());
+        report_handle_.reset();
+      }
+      return;
+    }
     reportHelper(true);
     if (is_grpc_) {
       tags_.push_back({context_.request_protocol_, context_.grpc_});
@@ -849,18 +2371,17 @@ public:
       tags_.push_back({context_.request_protocol_, context_.http_});
     }
 
-    // TODO: copy Http::CodeStatsImpl version for status codes and flags.
     tags_.push_back(
-        {context_.response_code_, pool_.add(absl::StrCat(info.responseCode().value_or(0)))});
+        {context_.response_code_, context_.responseCode(info.responseCode().value_or(0), pool_)});
     if (is_grpc_) {
       auto const& optional_status = Grpc::Common::getGrpcStatus(
           response_trailers ? *response_trailers
                             : *Http::StaticEmptyHeaders::get().response_trailers,
           response_headers ? *response_headers : *Http::StaticEmptyHeaders::get().response_headers,
           info);
-      tags_.push_back(
-          {context_.grpc_response_status_,
-           optional_status ? pool_.add(absl::StrCat(optional_status.value())) : context_.empty_});
+      tags_.push_back({context_.grpc_response_status_,
+                       optional_status ? context_.grpcStatus(optional_status.value(), pool_)
+                                       : context_.empty_});
     } else {
       tags_.push_back({context_.grpc_response_status_, context_.empty_});
     }
@@ -868,33 +2389,41 @@ public:
 
     // Evaluate the end stream override expressions for HTTP. This may change values for periodic
     // metrics.
-    stream_.evaluate(info, request_headers, response_headers, response_trailers);
+    stream_.evaluateValues(info, request_headers, response_headers, response_trailers);
     stream_.addCounter(context_.requests_total_, tags_);
-    auto duration = info.requestComplete();
-    if (duration.has_value()) {
-      stream_.recordHistogram(context_.request_duration_milliseconds_,
-                              Stats::Histogram::Unit::Milliseconds, tags_,
-                              absl::FromChrono(duration.value()) / absl::Milliseconds(1));
-    }
-    auto meter = info.getDownstreamBytesMeter();
-    if (meter) {
-      stream_.recordHistogram(context_.request_bytes_, Stats::Histogram::Unit::Bytes, tags_,
-                              meter->wireBytesReceived());
-      stream_.recordHistogram(context_.response_bytes_, Stats::Histogram::Unit::Bytes, tags_,
-                              meter->wireBytesSent());
+    if (config_->histogramSampled(info)) {
+      const auto& sampling_tag = config_->histogram_sampling_tag_;
+      if (sampling_tag.has_value()) {
+        tags_.push_back(sampling_tag.value());
+      }
+      auto duration = info.requestComplete();
+      if (duration.has_value()) {
+        stream_.recordHistogram(context_.request_duration_milliseconds_,
+                                Stats::Histogram::Unit::Milliseconds, tags_,
+                                absl::FromChrono(duration.value()) / absl::Milliseconds(1));
+      }
+      auto meter = info.getDownstreamBytesMeter();
+      if (meter) {
+        stream_.recordHistogram(context_.request_bytes_, Stats::Histogram::Unit::Bytes, tags_,
+                                meter->wireBytesReceived());
+        stream_.recordHistogram(context_.response_bytes_, Stats::Histogram::Unit::Bytes, tags_,
+                                meter->wireBytesSent());
+      }
+      if (sampling_tag.has_value()) {
+        tags_.pop_back();
+      }
     }
     stream_.recordCustomMetrics();
   }
 
   // Network::ReadFilter
   Network::FilterStatus onData(Buffer::Instance&, bool) override {
+    resetIdleBackoff();
     return Network::FilterStatus::Continue;
   }
   Network::FilterStatus onNewConnection() override {
     if (config_->report_duration_ > std::chrono::milliseconds(0)) {
-      report_timer_ = network_read_callbacks_->connection().dispatcher().createTimer(
-          [this] { onReportTimer(); });
-      report_timer_->enableTimer(config_->report_duration_);
+      report_handle_ = config_->reports().add(*this);
     }
     return Network::FilterStatus::Continue;
   }
@@ -902,6 +2431,11 @@ public:
     network_read_callbacks_ = &callbacks;
     network_read_callbacks_->connection().addConnectionCallbacks(*this);
   }
+  // Network::WriteFilter
+  Network::FilterStatus onWrite(Buffer::Instance&, bool) override {
+    resetIdleBackoff();
+    return Network::FilterStatus::Continue;
+  }
   // Network::ConnectionCallbacks
   void onEvent(Network::ConnectionEvent event) override {
     switch (event) {
@@ -919,9 +2453,9 @@ public:
 private:
   // Invoked periodically for streams.
   void reportHelper(bool end_stream) {
-    if (end_stream && report_timer_) {
-      report_timer_->disableTimer();
-      report_timer_.reset();
+    if (end_stream && report_handle_.has_value()) {
+      config_->reports().remove(report_handle_.value());
+      report_handle_.reset();
     }
     // HTTP handled first.
     if (decoder_callbacks_) {
@@ -932,9 +2466,12 @@ private:
           ENVOY_LOG(trace, "Populating peer metadata from HTTP MX.");
           populatePeerInfo(info, info.filterState());
         }
-        if (is_grpc_ && (peer_read_ || end_stream)) {
+        if (is_grpc_ && peer_read_ && !end_stream) {
           // For periodic HTTP metric, evaluate once when the peer info is read.
           stream_.evaluate(decoder_callbacks_->streamInfo());
+        } else if (is_grpc_ && end_stream) {
+          // The predicates are already evaluated with the headers at the end of the stream.
+          stream_.evaluateValues(decoder_callbacks_->streamInfo());
         }
       }
       if (is_grpc_ && (peer_read_ || end_stream)) {
@@ -964,27 +2501,51 @@ private:
             ? *upstream_info->upstreamFilterState()
             : info.filterState();
 
+    if (dropped_) {
+      return;
+    }
+    bool opened = false;
     if (!peer_read_) {
       peer_read_ = peerInfoRead(config_->reporter(), filter_state);
       // Report connection open once peer info is read or connection is closed.
       if (peer_read_ || end_stream) {
+        // For TCP, evaluate only once immediately before emitting the first
+        // metric. The predicates go first, so that the connections dropping
+        // all their metrics skip building the tags.
+        stream_.evaluateMatches(info);
+        if (stream_.dropsAll(context_.tcp_metrics_)) {
+          dropped_ = true;
+          if (report_handle_.has_value()) {
+            config_->reports().remove(report_handle_.value());
+            report_handle_.reset();
+          }
+          return;
+        }
         ENVOY_LOG(trace, "Populating peer metadata from TCP MX.");
         populatePeerInfo(info, filter_state);
         tags_.push_back({context_.request_protocol_, context_.tcp_});
         populateFlagsAndConnectionSecurity(info);
-        // For TCP, evaluate only once immediately before emitting the first metric.
-        stream_.evaluate(info);
+        stream_.evaluateValues(info);
         stream_.addCounter(context_.tcp_connections_opened_total_, tags_);
+        opened = true;
       }
     }
     if (peer_read_ || end_stream) {
       auto meter = info.getDownstreamBytesMeter();
       if (meter) {
-        stream_.addCounter(context_.tcp_sent_bytes_total_, tags_,
-                           meter->wireBytesSent() - bytes_sent_);
+        const uint64_t sent = meter->wireBytesSent() - bytes_sent_;
+        const uint64_t received = meter->wireBytesReceived() - bytes_received_;
+        if (!end_stream && !opened && sent == 0 && received == 0) {
+          // Skip the periodic report of an idle connection, and back off
+          // until it sees traffic again.
+          idle_backoff_ = std::min(idle_backoff_ + 1, MaxIdleBackoff);
+          skipped_reports_ = (1u << idle_backoff_) - 1;
+          return;
+        }
+        idle_backoff_ = 0;
+        stream_.addCounter(context_.tcp_sent_bytes_total_, tags_, sent);
         bytes_sent_ = meter->wireBytesSent();
-        stream_.addCounter(context_.tcp_received_bytes_total_, tags_,
-                           meter->wireBytesReceived() - bytes_received_);
+        stream_.addCounter(context_.tcp_received_bytes_total_, tags_, received);
         bytes_received_ = meter->wireBytesReceived();
       }
     }
@@ -993,14 +2554,131 @@ private:
       stream_.recordCustomMetrics();
     }
   }
-  void onReportTimer() {
+  // Traffic resumed on an idle connection, report it at the next interval.
+  void resetIdleBackoff() {
+    idle_backoff_ = 0;
+    skipped_reports_ = 0;
+  }
+  // PeriodicReport
+  void onReport() override {
+    if (skipped_reports_ > 0) {
+      skipped_reports_--;
+      return;
+    }
     reportHelper(false);
-    report_timer_->enableTimer(config_->report_duration_);
+  }
+
+  Stats::StatName intern(absl::string_view value) { return config_->intern(value, name_refs_); }
+  // Returns the pre-interned stat name of the value if any. The symbolic names
+  // take precedence, so that the value has the same encoding as elsewhere.
+  Stats::StatName intern(absl::string_view value, const NameRef& name) {
+    if (name && !context_.symbolic_values_.contains(value)) {
+      name_refs_.push_back(name);
+      return name->statName();
+    }
+    return intern(value);
+  }
+
+  // Appends the local tag block of the reporter, and returns its position.
+  template <Reporter R> size_t appendLocalTags() {
+    const auto& block = context_.localTags<R>();
+    const size_t local = tags_.size();
+    tags_.insert(tags_.end(), block.begin(), block.end());
+    return local;
+  }
+
+  // Returns the tags derived from the downstream peer. For HTTP, the tags are
+  // cached on the connection and reused by the following streams from the same
+  // peer workload with the same principals.
+  std::shared_ptr<const ServerPeerTags>
+  serverPeerTags(const StreamInfo::StreamInfo& info,
+                 const Istio::Common::WorkloadMetadataObjectConstSharedPtr& peer) {
+    auto peer_principal =
+        info.filterState().getDataReadOnly<Router::StringAccessor>("io.istio.peer_principal");
+    auto local_principal =
+        info.filterState().getDataReadOnly<Router::StringAccessor>("io.istio.local_principal");
+    absl::string_view peer_san = peer_principal ? peer_principal->asString() : "";
+    absl::string_view local_san = local_principal ? local_principal->asString() : "";
+
+    // This fallback should be deleted once istio_authn is globally enabled.
+    if (peer_san.empty() && local_san.empty()) {
+      const Ssl::ConnectionInfoConstSharedPtr ssl_info =
+          info.downstreamAddressProvider().sslConnection();
+      if (ssl_info && !ssl_info->uriSanPeerCertificate().empty()) {
+        peer_san = ssl_info->uriSanPeerCertificate()[0];
+      }
+      if (ssl_info && !ssl_info->uriSanLocalCertificate().empty()) {
+        local_san = ssl_info->uriSanLocalCertificate()[0];
+      }
+    }
+
+    StreamInfo::FilterState* connection_state =
+        decoder_callbacks_ ? decoder_callbacks_->streamInfo().filterState().get() : nullptr;
+    if (connection_state) {
+      auto cached = std::dynamic_pointer_cast<const ServerPeerTags>(
+          connection_state->getDataSharedMutableGeneric(ServerPeerTagsKey));
+      if (cached && cached->matches(peer.get(), peer_san, local_san)) {
+        return cached;
+      }
+    }
+
+    // Implements fallback from using the namespace from SAN if available to
+    // using peer metadata, otherwise.
+    absl::string_view peer_namespace;
+    if (!peer_san.empty()) {
+      const auto san_namespace = getNamespace(peer_san);
+      if (san_namespace) {
+        peer_namespace = san_namespace.value();
+      }
+    }
+    if (peer_namespace.empty() && peer) {
+      peer_namespace = peer->namespace_name_;
+    }
+
+    auto result = std::make_shared<ServerPeerTags>();
+    result->peer_ = peer;
+    result->peer_san_ = std::string(peer_san);
+    result->local_san_ = std::string(local_san);
+    result->mutual_tls_ = !peer_san.empty() && !local_san.empty();
+    auto name = [this, &refs = result->name_refs_](absl::string_view value) {
+      return config_->intern(value, refs);
+    };
+    auto& tags = result->source_tags_;
+    tags.reserve(8);
+    tags.push_back({context_.source_workload_, peer && !peer->workload_name_.empty()
+                                                   ? name(peer->workload_name_)
+                                                   : context_.unknown_});
+    tags.push_back({context_.source_canonical_service_, peer && !peer->canonical_name_.empty()
+                                                            ? name(peer->canonical_name_)
+                                                            : context_.unknown_});
+    tags.push_back({context_.source_canonical_revision_, peer && !peer->canonical_revision_.empty()
+                                                             ? name(peer->canonical_revision_)
+                                                             : context_.latest_});
+    tags.push_back({context_.source_workload_namespace_,
+                    !peer_namespace.empty() ? name(peer_namespace) : context_.unknown_});
+    tags.push_back(
+        {context_.source_principal_, !peer_san.empty() ? name(peer_san) : context_.unknown_});
+    tags.push_back({context_.source_app_, peer && !peer->app_name_.empty()
+                                              ? name(peer->app_name_)
+                                              : context_.unknown_});
+    tags.push_back({context_.source_version_, peer && !peer->app_version_.empty()
+                                                  ? name(peer->app_version_)
+                                                  : context_.unknown_});
+    tags.push_back({context_.source_cluster_, peer && !peer->cluster_name_.empty()
+                                                  ? name(peer->cluster_name_)
+                                                  : context_.unknown_});
+    result->local_principal_ = !local_san.empty() ? name(local_san) : context_.unknown_;
+
+    if (connection_state) {
+      connection_state->setData(ServerPeerTagsKey, result,
+                                StreamInfo::FilterState::StateType::Mutable,
+                                StreamInfo::FilterState::LifeSpan::Connection);
+    }
+    return result;
   }
 
   void populateFlagsAndConnectionSecurity(const StreamInfo::StreamInfo& info) {
-    tags_.push_back(
-        {context_.response_flags_, pool_.add(StreamInfo::ResponseFlagUtils::toShortString(info))});
+    tags_.push_back({context_.response_flags_, context_.responseFlags(info, pool_)});
     tags_.push_back({context_.connection_security_policy_,
                      mutual_tls_.has_value()
                          ? (*mutual_tls_ ? context_.mutual_tls_ : context_.none_)
@@ -1012,13 +2690,15 @@ private:
   void populatePeerInfo(const StreamInfo::StreamInfo& info,
                         const StreamInfo::FilterState& filter_state) {
     // Compute peer info with client-side fallbacks.
-    absl::optional<Istio::Common::WorkloadMetadataObject> peer;
-    auto object = peerInfo(config_->reporter(), filter_state);
-    if (object) {
-      peer.emplace(object.value());
-    } else if (config_->reporter() == Reporter::ClientSidecar) {
-      if (auto label_obj = extractEndpointMetadata(info); label_obj) {
-        peer.emplace(label_obj.value());
+    const Istio::Common::WorkloadMetadataObjectConstSharedPtr object =
+        peerInfo(config_->reporter(), filter_state);
+    Istio::Common::WorkloadMetadataObjectConstSharedPtr peer = object;
+    if (!peer && config_->reporter() == Reporter::ClientSidecar) {
+      auto host_metadata = extractEndpointMetadata(*config_->host_metadata_, info);
+      if (host_metadata && host_metadata->workload_) {
+        // Shares the ownership of the cached host metadata.
+        peer = Istio::Common::WorkloadMetadataObjectConstSharedPtr(
+            host_metadata, &host_metadata->workload_.value());
       }
     }
 
@@ -1026,6 +2706,10 @@ private:
     absl::string_view service_host;
     absl::string_view service_host_name;
     absl::string_view service_namespace;
+    // Stat names pre-interned in the cluster metadata for the values above.
+    NameRef service_host_ref;
+    NameRef service_host_name_ref;
+    NameRef service_namespace_ref;
     if (!config_->disable_host_header_fallback_) {
       const auto* headers = info.getRequestHeaders();
       if (headers && headers->Host()) {
@@ -1047,29 +2731,22 @@ private:
             cluster_name == "InboundPassthroughClusterIpv6") {
           service_host_name = cluster_name;
         } else {
-          const auto& filter_metadata = cluster_info.value()->metadata().filter_metadata();
-          const auto& it = filter_metadata.find("istio");
-          if (it != filter_metadata.end()) {
-            const auto& services_it = it->second.fields().find("services");
-            if (services_it != it->second.fields().end()) {
-              const auto& services = services_it->second.list_value();
-              if (services.values_size() > 0) {
-                const auto& service = services.values(0).struct_value().fields();
-                const auto& host_it = service.find("host");
-                if (host_it != service.end()) {
-                  service_host = host_it->second.string_value();
-                }
-                const auto& name_it = service.find("name");
-                const auto& namespace_it = service.find("namespace");
-                if (namespace_it != service.end()) {
-                  service_namespace = namespace_it->second.string_value();
-                }
-                if (name_it != service.end()) {
-                  service_host_name = name_it->second.string_value();
-                } else {
-                  service_host_name = service_host.substr(0, service_host.find_first_of('.'));
-                }
-              }
+          const auto* istio = Istio::Common::ClusterMetadata::get(*cluster_info.value());
+          if (istio && istio->has_service_) {
+            const auto& names = istio->serviceStatNames(config_->symbolTable());
+            if (istio->service_host_) {
+              service_host = *istio->service_host_;
+              service_host_ref = names.host_;
+            }
+            if (istio->service_namespace_) {
+              service_namespace = *istio->service_namespace_;
+              service_namespace_ref = names.namespace_;
+            }
+            if (istio->service_name_) {
+              service_host_name = *istio->service_name_;
+              service_host_name_ref = names.name_;
+            } else {
+              service_host_name = service_host.substr(0, service_host.find_first_of('.'));
             }
           }
         }
@@ -1080,43 +2757,19 @@ private:
     absl::string_view local_san;
     switch (config_->reporter()) {
     case Reporter::ServerSidecar:
-    case Reporter::ServerGateway: {
-      auto peer_principal =
-          info.filterState().getDataReadOnly<Router::StringAccessor>("io.istio.peer_principal");
-      auto local_principal =
-          info.filterState().getDataReadOnly<Router::StringAccessor>("io.istio.local_principal");
-      peer_san = peer_principal ? peer_principal->asString() : "";
-      local_san = local_principal ? local_principal->asString() : "";
-
-      // This fallback should be deleted once istio_authn is globally enabled.
-      if (peer_san.empty() && local_san.empty()) {
-        const Ssl::ConnectionInfoConstSharedPtr ssl_info =
-            info.downstreamAddressProvider().sslConnection();
-        if (ssl_info && !ssl_info->uriSanPeerCertificate().empty()) {
-          peer_san = ssl_info->uriSanPeerCertificate()[0];
-        }
-        if (ssl_info && !ssl_info->uriSanLocalCertificate().empty()) {
-          local_san = ssl_info->uriSanLocalCertificate()[0];
-        }
-      }
-
+    case Reporter::ServerGateway:
+      server_peer_ = serverPeerTags(info, peer);
       // Save the connection security policy for a tag added later.
-      mutual_tls_ = !peer_san.empty() && !local_san.empty();
+      mutual_tls_ = server_peer_->mutual_tls_;
       break;
-    }
     case Reporter::ClientSidecar: {
       const Ssl::ConnectionInfoConstSharedPtr ssl_info =
           info.upstreamInfo() ? info.upstreamInfo()->upstreamSslConnection() : nullptr;
-      std::optional<Istio::Common::WorkloadMetadataObject> endpoint_peer;
       if (ssl_info && !ssl_info->uriSanPeerCertificate().empty()) {
         peer_san = ssl_info->uriSanPeerCertificate()[0];
       }
-      if (peer_san.empty()) {
-        auto endpoint_object = peerInfo(config_->reporter(), filter_state);
-        if (endpoint_object) {
-          endpoint_peer.emplace(endpoint_object.value());
-          peer_san = endpoint_peer->identity_;
-        }
+      if (peer_san.empty() && object) {
+        peer_san = object->identity_;
       }
       // This won't work for sidecar/ingress -> ambient becuase of the CONNECT
       // tunnel.
@@ -1141,143 +2794,115 @@ private:
     switch (config_->reporter()) {
     case Reporter::ServerSidecar:
     case Reporter::ServerGateway: {
-      tags_.push_back({context_.source_workload_, peer && !peer->workload_name_.empty()
-                                                      ? pool_.add(peer->workload_name_)
-                                                      : context_.unknown_});
-      tags_.push_back({context_.source_canonical_service_, peer && !peer->canonical_name_.empty()
-                                                               ? pool_.add(peer->canonical_name_)
-                                                               : context_.unknown_});
-      tags_.push_back(
-          {context_.source_canonical_revision_, peer && !peer->canonical_revision_.empty()
-                                                    ? pool_.add(peer->canonical_revision_)
-                                                    : context_.latest_});
-      tags_.push_back({context_.source_workload_namespace_,
-                       !peer_namespace.empty() ? pool_.add(peer_namespace) : context_.unknown_});
-      tags_.push_back({context_.source_principal_,
-                       !peer_san.empty() ? pool_.add(peer_san) : context_.unknown_});
-      tags_.push_back({context_.source_app_, peer && !peer->app_name_.empty()
-                                                 ? pool_.add(peer->app_name_)
-                                                 : context_.unknown_});
-      tags_.push_back({context_.source_version_, peer && !peer->app_version_.empty()
-                                                     ? pool_.add(peer->app_version_)
-                                                     : context_.unknown_});
-      tags_.push_back({context_.source_cluster_, peer && !peer->cluster_name_.empty()
-                                                     ? pool_.add(peer->cluster_name_)
-                                                     : context_.unknown_});
+      tags_.insert(tags_.end(), server_peer_->source_tags_.begin(),
+                   server_peer_->source_tags_.end());
       switch (config_->reporter()) {
       case Reporter::ServerGateway: {
-        std::optional<Istio::Common::WorkloadMetadataObject> endpoint_peer;
-        auto endpoint_object = peerInfo(Reporter::ClientSidecar, filter_state);
-        if (endpoint_object) {
-          endpoint_peer.emplace(endpoint_object.value());
-        }
+        const Istio::Common::WorkloadMetadataObjectConstSharedPtr endpoint_peer =
+            peerInfo(Reporter::ClientSidecar, filter_state);
         tags_.push_back(
             {context_.destination_workload_, endpoint_peer && !endpoint_peer->workload_name_.empty()
-                                                 ? pool_.add(endpoint_peer->workload_name_)
+                                                 ? intern(endpoint_peer->workload_name_)
                                                  : context_.unknown_});
         tags_.push_back({context_.destination_workload_namespace_,
                          endpoint_peer && !endpoint_peer->namespace_name_.empty()
-                             ? pool_.add(endpoint_peer->namespace_name_)
+                             ? intern(endpoint_peer->namespace_name_)
                              : context_.unknown_});
         tags_.push_back(
             {context_.destination_principal_, endpoint_peer && !endpoint_peer->identity_.empty()
-                                                  ? pool_.add(endpoint_peer->identity_)
+                                                  ? intern(endpoint_peer->identity_)
                                                   : context_.unknown_});
         // Endpoint encoding does not have app and version.
         tags_.push_back(
             {context_.destination_app_, endpoint_peer && !endpoint_peer->app_name_.empty()
-                                            ? pool_.add(endpoint_peer->app_name_)
+                                            ? intern(endpoint_peer->app_name_)
                                             : context_.unknown_});
         tags_.push_back(
             {context_.destination_version_, endpoint_peer && !endpoint_peer->app_version_.empty()
-                                                ? pool_.add(endpoint_peer->app_version_)
+                                                ? intern(endpoint_peer->app_version_)
                                                 : context_.unknown_});
         tags_.push_back({context_.destination_service_,
-                         service_host.empty() ? context_.unknown_ : pool_.add(service_host)});
+                         service_host.empty() ? context_.unknown_
+                                              : intern(service_host, service_host_ref)});
         tags_.push_back({context_.destination_canonical_service_,
                          endpoint_peer && !endpoint_peer->canonical_name_.empty()
-                             ? pool_.add(endpoint_peer->canonical_name_)
+                             ? intern(endpoint_peer->canonical_name_)
                              : context_.unknown_});
         tags_.push_back({context_.destination_canonical_revision_,
                          endpoint_peer && !endpoint_peer->canonical_revision_.empty()
-                             ? pool_.add(endpoint_peer->canonical_revision_)
+                             ? intern(endpoint_peer->canonical_revision_)
+                             : context_.unknown_});
+        tags_.push_back({context_.destination_service_name_,
+                         service_host_name.empty()
+                             ? context_.unknown_
+                             : intern(service_host_name, service_host_name_ref)});
+        tags_.push_back({context_.destination_service_namespace_,
+                         !service_namespace.empty()
+                             ? intern(service_namespace, service_namespace_ref)
                              : context_.unknown_});
-        tags_.push_back({context_.destination_service_name_, service_host_name.empty()
-                                                                 ? context_.unknown_
-                                                                 : pool_.add(service_host_name)});
-        tags_.push_back({context_.destination_service_namespace_, !service_namespace.empty()
-                                                                      ? pool_.add(service_namespace)
-                                                                      : context_.unknown_});
         tags_.push_back(
             {context_.destination_cluster_, endpoint_peer && !endpoint_peer->cluster_name_.empty()
-                                                ? pool_.add(endpoint_peer->cluster_name_)
+                                                ? intern(endpoint_peer->cluster_name_)
                                                 : context_.unknown_});
         break;
       }
-      default:
-        tags_.push_back({context_.destination_workload_, context_.workload_name_});
-        tags_.push_back({context_.destination_workload_namespace_, context_.namespace_});
-        tags_.push_back({context_.destination_principal_,
-                         !local_san.empty() ? pool_.add(local_san) : context_.unknown_});
-        tags_.push_back({context_.destination_app_, context_.app_name_});
-        tags_.push_back({context_.destination_version_, context_.app_version_});
-        tags_.push_back({context_.destination_service_, service_host.empty()
-                                                            ? context_.canonical_name_
-                                                            : pool_.add(service_host)});
-        tags_.push_back({context_.destination_canonical_service_, context_.canonical_name_});
-        tags_.push_back({context_.destination_canonical_revision_, context_.canonical_revision_});
-        tags_.push_back({context_.destination_service_name_, service_host_name.empty()
-                                                                 ? context_.canonical_name_
-                                                                 : pool_.add(service_host_name)});
-        tags_.push_back({context_.destination_service_namespace_, context_.namespace_});
-        tags_.push_back({context_.destination_cluster_, context_.cluster_name_});
+      default: {
+        using Block = LocalTagBlock<Reporter::ServerSidecar>;
+        const size_t local = appendLocalTags<Reporter::ServerSidecar>();
+        tags_[local + Block::Principal].second = server_peer_->local_principal_;
+        if (!service_host.empty()) {
+          tags_[local + Block::Service].second = intern(service_host, service_host_ref);
+        }
+        if (!service_host_name.empty()) {
+          tags_[local + Block::ServiceName].second =
+              intern(service_host_name, service_host_name_ref);
+        }
         break;
       }
+      }
 
       break;
     }
     case Reporter::ClientSidecar: {
-      tags_.push_back({context_.source_workload_, context_.workload_name_});
-      tags_.push_back({context_.source_canonical_service_, context_.canonical_name_});
-      tags_.push_back({context_.source_canonical_revision_, context_.canonical_revision_});
-      tags_.push_back({context_.source_workload_namespace_, context_.namespace_});
-      tags_.push_back({context_.source_principal_,
-                       !local_san.empty() ? pool_.add(local_san) : context_.unknown_});
-      tags_.push_back({context_.source_app_, context_.app_name_});
-      tags_.push_back({context_.source_version_, context_.app_version_});
-      tags_.push_back({context_.source_cluster_, context_.cluster_name_});
+      const size_t local = appendLocalTags<Reporter::ClientSidecar>();
+      if (!local_san.empty()) {
+        tags_[local + LocalTagBlock<Reporter::ClientSidecar>::Principal].second =
+            intern(local_san);
+      }
       tags_.push_back({context_.destination_workload_, peer && !peer->workload_name_.empty()
-                                                           ? pool_.add(peer->workload_name_)
+                                                           ? intern(peer->workload_name_)
                                                            : context_.unknown_});
       tags_.push_back({context_.destination_workload_namespace_,
-                       !peer_namespace.empty() ? pool_.add(peer_namespace) : context_.unknown_});
+                       !peer_namespace.empty() ? intern(peer_namespace) : context_.unknown_});
       tags_.push_back({context_.destination_principal_,
-                       !peer_san.empty() ? pool_.add(peer_san) : context_.unknown_});
+                       !peer_san.empty() ? intern(peer_san) : context_.unknown_});
       tags_.push_back({context_.destination_app_, peer && !peer->app_name_.empty()
-                                                      ? pool_.add(peer->app_name_)
+                                                      ? intern(peer->app_name_)
                                                       : context_.unknown_});
       tags_.push_back({context_.destination_version_, peer && !peer->app_version_.empty()
-                                                          ? pool_.add(peer->app_version_)
+                                                          ? intern(peer->app_version_)
                                                           : context_.unknown_});
       tags_.push_back({context_.destination_service_,
-                       service_host.empty() ? context_.unknown_ : pool_.add(service_host)});
+                       service_host.empty() ? context_.unknown_
+                                            : intern(service_host, service_host_ref)});
       tags_.push_back({context_.destination_canonical_service_,
-                       peer && !peer->canonical_name_.empty() ? pool_.add(peer->canonical_name_)
+                       peer && !peer->canonical_name_.empty() ? intern(peer->canonical_name_)
                                                               : context_.unknown_});
       tags_.push_back(
           {context_.destination_canonical_revision_, peer && !peer->canonical_revision_.empty()
-                                                         ? pool_.add(peer->canonical_revision_)
+                                                         ? intern(peer->canonical_revision_)
                                                          : context_.latest_});
-      tags_.push_back({context_.destination_service_name_, service_host_name.empty()
-                                                               ? context_.unknown_
-                                                               : pool_.add(service_host_name)});
+      tags_.push_back({context_.destination_service_name_,
+                       service_host_name.empty()
+                           ? context_.unknown_
+                           : intern(service_host_name, service_host_name_ref)});
       tags_.push_back(
           {context_.destination_service_namespace_,
            !service_namespace.empty()
-               ? pool_.add(service_namespace)
-               : (!peer_namespace.empty() ? pool_.add(peer_namespace) : context_.unknown_)});
+               ? intern(service_namespace, service_namespace_ref)
+               : (!peer_namespace.empty() ? intern(peer_namespace) : context_.unknown_)});
       tags_.push_back({context_.destination_cluster_, peer && !peer->cluster_name_.empty()
-                                                          ? pool_.add(peer->cluster_name_)
+                                                          ? intern(peer->cluster_name_)
                                                           : context_.unknown_});
       break;
     }
@@ -1289,10 +2914,20 @@ private:
   ConfigSharedPtr config_;
   Context& context_;
   Stats::StatNameDynamicPool pool_;
+  // References to the cached peer-derived names used in the tags.
+  std::vector<NameRef> name_refs_;
+  // Tags derived from the downstream peer by the server reporters.
+  std::shared_ptr<const ServerPeerTags> server_peer_;
   Stats::StatNameTagVector tags_;
-  Event::TimerPtr report_timer_{nullptr};
+  absl::optional<ReportWheel::Handle> report_handle_;
+  // Idle connections back off up to 2^MaxIdleBackoff reporting intervals.
+  static constexpr uint32_t MaxIdleBackoff = 4;
+  uint32_t idle_backoff_{0};
+  uint32_t skipped_reports_{0};
   Network::ReadFilterCallbacks* network_read_callbacks_;
   bool peer_read_{false};
+  // Set if the connection drops all its metrics.
+  bool dropped_{false};
   uint64_t bytes_sent_{0};
   uint64_t bytes_received_{0};
   absl::optional<bool> mutual_tls_;
@@ -1332,7 +2967,8 @@ IstioStatsNetworkFilterConfigFactory::createFilterFactoryFromProto(
   ConfigSharedPtr config = std::make_shared<Config>(
       dynamic_cast<const stats::PluginConfig&>(proto_config), factory_context);
   return [config](Network::FilterManager& filter_manager) {
-    filter_manager.addReadFilter(std::make_shared<IstioStatsFilter>(config));
+    // Also added as a write filter to observe traffic resuming on idle connections.
+    filter_manager.addFilter(std::make_shared<IstioStatsFilter>(config));
   };
 }
 
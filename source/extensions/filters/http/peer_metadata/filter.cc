@@ -22,6 +22,8 @@
 #include "source/common/http/utility.h"
 #include "source/common/network/utility.h"
 
+#include "extensions/common/cluster_metadata.h"
+#include "extensions/common/host_metadata.h"
 #include "extensions/common/metadata_object.h"
 
 namespace Envoy {
@@ -35,19 +37,21 @@ class XDSMethod : public DiscoveryMethod {
 public:
   XDSMethod(bool downstream, Server::Configuration::ServerFactoryContext& factory_context)
       : downstream_(downstream),
-        metadata_provider_(Extensions::Common::WorkloadDiscovery::GetProvider(factory_context)) {}
-  absl::optional<PeerInfo> derivePeerInfo(const StreamInfo::StreamInfo&, Http::HeaderMap&,
-                                          Context&) const override;
+        metadata_provider_(Extensions::Common::WorkloadDiscovery::GetProvider(factory_context)),
+        host_metadata_(Istio::Common::HostMetadataCache::get(factory_context)) {}
+  PeerInfoConstSharedPtr derivePeerInfo(const StreamInfo::StreamInfo&, Http::HeaderMap&,
+                                        Context&) const override;
 
 private:
   const bool downstream_;
   Extensions::Common::WorkloadDiscovery::WorkloadMetadataProviderSharedPtr metadata_provider_;
+  Istio::Common::HostMetadataCacheSharedPtr host_metadata_;
 };
 
-absl::optional<PeerInfo> XDSMethod::derivePeerInfo(const StreamInfo::StreamInfo& info,
-                                                   Http::HeaderMap&, Context&) const {
+PeerInfoConstSharedPtr XDSMethod::derivePeerInfo(const StreamInfo::StreamInfo& info,
+                                                 Http::HeaderMap&, Context&) const {
   if (!metadata_provider_) {
-    return {};
+    return nullptr;
   }
   Network::Address::InstanceConstSharedPtr peer_address;
   if (downstream_) {
@@ -62,16 +66,8 @@ absl::optional<PeerInfo> XDSMethod::derivePeerInfo(const StreamInfo::StreamInfo&
           peer_address = upstream_host->address();
           break;
         case Network::Address::Type::EnvoyInternal:
-          if (upstream_host->metadata()) {
-            const auto& filter_metadata = upstream_host->metadata()->filter_metadata();
-            const auto& it = filter_metadata.find("envoy.filters.listener.original_dst");
-            if (it != filter_metadata.end()) {
-              const auto& destination_it = it->second.fields().find("local");
-              if (destination_it != it->second.fields().end()) {
-                peer_address = Network::Utility::parseInternetAddressAndPortNoThrow(
-                    destination_it->second.string_value(), /*v6only=*/false);
-              }
-            }
+          if (const auto host_metadata = host_metadata_->lookup(*upstream_host); host_metadata) {
+            peer_address = host_metadata->original_dst_;
           }
           break;
         default:
@@ -91,8 +87,8 @@ MXMethod::MXMethod(bool downstream, const absl::flat_hash_set<std::string> addit
   tls_.set([](Event::Dispatcher&) { return std::make_shared<MXCache>(); });
 }
 
-absl::optional<PeerInfo> MXMethod::derivePeerInfo(const StreamInfo::StreamInfo&,
-                                                  Http::HeaderMap& headers, Context& ctx) const {
+PeerInfoConstSharedPtr MXMethod::derivePeerInfo(const StreamInfo::StreamInfo&,
+                                                Http::HeaderMap& headers, Context& ctx) const {
   const auto peer_id_header = headers.get(Headers::get().ExchangeMetadataHeaderId);
   if (downstream_) {
     ctx.request_peer_id_received_ = !peer_id_header.empty();
@@ -108,7 +104,7 @@ absl::optional<PeerInfo> MXMethod::derivePeerInfo(const StreamInfo::StreamInfo&,
   if (!peer_info.empty()) {
     return lookup(peer_id, peer_info);
   }
-  return {};
+  return nullptr;
 }
 
 void MXMethod::remove(Http::HeaderMap& headers) const {
@@ -116,7 +112,7 @@ void MXMethod::remove(Http::HeaderMap& headers) const {
   headers.remove(Headers::get().ExchangeMetadataHeader);
 }
 
-absl::optional<PeerInfo> MXMethod::lookup(absl::string_view id, absl::string_view value) const {
+PeerInfoConstSharedPtr MXMethod::lookup(absl::string_view id, absl::string_view value) const {
   // This code is copied from:
   // https://github.com/istio/proxy/blob/release-1.18/extensions/metadata_exchange/plugin.cc#L116
   auto& cache = tls_->cache_;
@@ -129,17 +125,18 @@ absl::optional<PeerInfo> MXMethod::lookup(absl::string_view id, absl::string_vie
   const auto bytes = Base64::decodeWithoutPadding(value);
   google::protobuf::Struct metadata;
   if (!metadata.ParseFromString(bytes)) {
-    return {};
+    return nullptr;
   }
-  auto out = Istio::Common::convertStructToWorkloadMetadata(metadata, additional_labels_);
+  PeerInfoConstSharedPtr out =
+      Istio::Common::convertStructToWorkloadMetadata(metadata, additional_labels_);
   if (max_peer_cache_size_ > 0 && !id.empty()) {
     // do not let the cache grow beyond max cache size.
     if (static_cast<uint32_t>(cache.size()) > max_peer_cache_size_) {
       cache.erase(cache.begin(), std::next(cache.begin(), max_peer_cache_size_ / 4));
     }
-    cache.emplace(id, *out);
+    cache.emplace(id, out);
   }
-  return *out;
+  return out;
 }
 
 MXPropagationMethod::MXPropagationMethod(
@@ -176,6 +173,7 @@ void MXPropagationMethod::inject(const StreamInfo::StreamInfo& info, Http::Heade
 FilterConfig::FilterConfig(const io::istio::http::peer_metadata::Config& config,
                            Server::Configuration::FactoryContext& factory_context)
     : shared_with_upstream_(config.shared_with_upstream()),
+      skip_cel_state_(config.skip_cel_state()),
       downstream_discovery_(buildDiscoveryMethods(config.downstream_discovery(),
                                                   buildAdditionalLabels(config.additional_labels()),
                                                   true, factory_context)),
@@ -261,7 +259,7 @@ void FilterConfig::discover(StreamInfo::StreamInfo& info, bool downstream, Http:
   for (const auto& method : downstream ? downstream_discovery_ : upstream_discovery_) {
     const auto result = method->derivePeerInfo(info, headers, ctx);
     if (result) {
-      setFilterState(info, downstream, *result);
+      setFilterState(info, downstream, result);
       break;
     }
   }
@@ -285,17 +283,28 @@ void FilterConfig::injectUpstream(const StreamInfo::StreamInfo& info,
 }
 
 void FilterConfig::setFilterState(StreamInfo::StreamInfo& info, bool downstream,
-                                  const PeerInfo& value) const {
+                                  const PeerInfoConstSharedPtr& value) const {
   const absl::string_view key =
       downstream ? Istio::Common::DownstreamPeer : Istio::Common::UpstreamPeer;
-  if (!info.filterState()->hasDataWithName(key)) {
-    // Use CelState to allow operation filter_state.upstream_peer.labels['role']
-    auto pb = value.serializeAsProto();
-    auto peer_info = std::make_unique<CelState>(FilterConfig::peerInfoPrototype());
-    peer_info->setValue(absl::string_view(pb->SerializeAsString()));
+  const absl::string_view object_key =
+      downstream ? Istio::Common::DownstreamPeerObject : Istio::Common::UpstreamPeerObject;
+  if (!info.filterState()->hasDataWithName(key) &&
+      !info.filterState()->hasDataWithName(object_key)) {
+    if (!skip_cel_state_) {
+      // Use CelState to allow operation filter_state.upstream_peer.labels['role']
+      auto pb = value->serializeAsProto();
+      auto peer_info = std::make_unique<CelState>(FilterConfig::peerInfoPrototype());
+      peer_info->setValue(absl::string_view(pb->SerializeAsString()));
+      info.filterState()->setData(
+          key, std::move(peer_info), StreamInfo::FilterState::StateType::Mutable,
+          StreamInfo::FilterState::LifeSpan::FilterChain, sharedWithUpstream());
+    }
+    // Typed handle for the native consumers, e.g. istio_stats. The instance is
+    // shared with the discovery caches.
     info.filterState()->setData(
-        key, std::move(peer_info), StreamInfo::FilterState::StateType::Mutable,
-        StreamInfo::FilterState::LifeSpan::FilterChain, sharedWithUpstream());
+        object_key, std::make_shared<Istio::Common::WorkloadMetadataHandle>(value),
+        StreamInfo::FilterState::StateType::Mutable, StreamInfo::FilterState::LifeSpan::FilterChain,
+        sharedWithUpstream());
   } else {
     ENVOY_LOG(debug, "Duplicate peer metadata, skipping");
   }
@@ -318,23 +327,14 @@ bool MXPropagationMethod::skipMXHeaders(const bool skip_external_clusters,
     if (skip_external_clusters && cluster_name == "PassthroughCluster") {
       return true;
     }
-    const auto& filter_metadata = cluster_info.value()->metadata().filter_metadata();
-    const auto& it = filter_metadata.find("istio");
     // Otherwise, cluster must be tagged as external
-    if (it != filter_metadata.end()) {
-      if (skip_external_clusters) {
-        const auto& skip_mx = it->second.fields().find("external");
-        if (skip_mx != it->second.fields().end()) {
-          if (skip_mx->second.bool_value()) {
-            return true;
-          }
-        }
+    const auto* istio = Istio::Common::ClusterMetadata::get(*cluster_info.value());
+    if (istio) {
+      if (skip_external_clusters && istio->external_) {
+        return true;
       }
-      const auto& skip_mx = it->second.fields().find("disable_mx");
-      if (skip_mx != it->second.fields().end()) {
-        if (skip_mx->second.bool_value()) {
-          return true;
-        }
+      if (istio->disable_mx_) {
+        return true;
       }
     }
   }
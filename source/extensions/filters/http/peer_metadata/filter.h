@@ -37,6 +37,7 @@ struct HeaderValues {
 using Headers = ConstSingleton<HeaderValues>;
 
 using PeerInfo = Istio::Common::WorkloadMetadataObject;
+using PeerInfoConstSharedPtr = std::shared_ptr<const PeerInfo>;
 
 struct Context {
   bool request_peer_id_received_{false};
@@ -47,8 +48,9 @@ struct Context {
 class DiscoveryMethod {
 public:
   virtual ~DiscoveryMethod() = default;
-  virtual absl::optional<PeerInfo> derivePeerInfo(const StreamInfo::StreamInfo&, Http::HeaderMap&,
-                                                  Context&) const PURE;
+  // Returns the peer, or nullptr if the method does not find it.
+  virtual PeerInfoConstSharedPtr derivePeerInfo(const StreamInfo::StreamInfo&, Http::HeaderMap&,
+                                                Context&) const PURE;
   virtual void remove(Http::HeaderMap&) const {}
 };
 
@@ -58,15 +60,15 @@ class MXMethod : public DiscoveryMethod {
 public:
   MXMethod(bool downstream, const absl::flat_hash_set<std::string> additional_labels,
            Server::Configuration::ServerFactoryContext& factory_context);
-  absl::optional<PeerInfo> derivePeerInfo(const StreamInfo::StreamInfo&, Http::HeaderMap&,
-                                          Context&) const override;
+  PeerInfoConstSharedPtr derivePeerInfo(const StreamInfo::StreamInfo&, Http::HeaderMap&,
+                                        Context&) const override;
   void remove(Http::HeaderMap&) const override;
 
 private:
-  absl::optional<PeerInfo> lookup(absl::string_view id, absl::string_view value) const;
+  PeerInfoConstSharedPtr lookup(absl::string_view id, absl::string_view value) const;
   const bool downstream_;
   struct MXCache : public ThreadLocal::ThreadLocalObject {
-    absl::flat_hash_map<std::string, PeerInfo> cache_;
+    absl::flat_hash_map<std::string, PeerInfoConstSharedPtr> cache_;
   };
   mutable ThreadLocal::TypedSlot<MXCache> tls_;
   const absl::flat_hash_set<std::string> additional_labels_;
@@ -132,8 +134,10 @@ private:
                : StreamInfo::StreamSharingMayImpactPooling::None;
   }
   void discover(StreamInfo::StreamInfo&, bool downstream, Http::HeaderMap&, Context&) const;
-  void setFilterState(StreamInfo::StreamInfo&, bool downstream, const PeerInfo& value) const;
+  void setFilterState(StreamInfo::StreamInfo&, bool downstream,
+                      const PeerInfoConstSharedPtr& value) const;
   const bool shared_with_upstream_;
+  const bool skip_cel_state_;
   const std::vector<DiscoveryMethodPtr> downstream_discovery_;
   const std::vector<DiscoveryMethodPtr> upstream_discovery_;
   const std::vector<PropagationMethodPtr> downstream_propagation_;
@@ -14,6 +14,7 @@
 
 #include "source/extensions/filters/http/peer_metadata/filter.h"
 
+#include "source/common/config/metadata.h"
 #include "source/common/network/address_impl.h"
 #include "test/common/stream_info/test_util.h"
 #include "test/mocks/stream_info/mocks.h"
@@ -24,6 +25,8 @@
 #include "gtest/gtest.h"
 
 using Istio::Common::WorkloadMetadataObject;
+using Istio::Common::WorkloadMetadataHandle;
+using Envoy::Extensions::Common::WorkloadDiscovery::WorkloadMetadataObjectConstSharedPtr;
 using testing::HasSubstr;
 using testing::Invoke;
 using testing::Return;
@@ -48,7 +51,7 @@ class MockWorkloadMetadataProvider
 public:
   MockWorkloadMetadataProvider() {}
   ~MockWorkloadMetadataProvider() override {}
-  MOCK_METHOD(std::optional<WorkloadMetadataObject>, GetMetadata,
+  MOCK_METHOD(WorkloadMetadataObjectConstSharedPtr, GetMetadata,
               (const Network::Address::InstanceConstSharedPtr& address));
 };
 
@@ -86,6 +89,10 @@ protected:
     ProtobufWkt::Struct obj;
     ASSERT_TRUE(obj.ParseFromString(cel_state->value().data()));
     EXPECT_EQ(expected, extractString(obj, "namespace"));
+    const auto* peer = stream_info_.filterState()->getDataReadOnly<WorkloadMetadataHandle>(
+        downstream ? Istio::Common::DownstreamPeerObject : Istio::Common::UpstreamPeerObject);
+    ASSERT_NE(nullptr, peer);
+    EXPECT_EQ(expected, peer->workload()->namespace_name_);
   }
 
   absl::string_view extractString(const ProtobufWkt::Struct& metadata, absl::string_view key) {
@@ -120,7 +127,7 @@ TEST_F(PeerMetadataTest, None) {
 }
 
 TEST_F(PeerMetadataTest, DownstreamXDSNone) {
-  EXPECT_CALL(*metadata_provider_, GetMetadata(_)).WillRepeatedly(Return(std::nullopt));
+  EXPECT_CALL(*metadata_provider_, GetMetadata(_)).WillRepeatedly(Return(nullptr));
   initialize(R"EOF(
     downstream_discovery:
       - workload_discovery: {}
@@ -136,11 +143,11 @@ TEST_F(PeerMetadataTest, DownstreamXDS) {
                                    "v1alpha3", "", "", Istio::Common::WorkloadType::Pod, "");
   EXPECT_CALL(*metadata_provider_, GetMetadata(_))
       .WillRepeatedly(Invoke([&](const Network::Address::InstanceConstSharedPtr& address)
-                                 -> std::optional<WorkloadMetadataObject> {
+                                 -> WorkloadMetadataObjectConstSharedPtr {
         if (absl::StartsWith(address->asStringView(), "127.0.0.1")) {
-          return {pod};
+          return std::make_shared<const WorkloadMetadataObject>(pod);
         }
-        return {};
+        return nullptr;
       }));
   initialize(R"EOF(
     downstream_discovery:
@@ -153,16 +160,33 @@ TEST_F(PeerMetadataTest, DownstreamXDS) {
   checkShared(false);
 }
 
+TEST_F(PeerMetadataTest, DownstreamXDSSkipCelState) {
+  const WorkloadMetadataObject pod("pod-foo-1234", "my-cluster", "default", "foo", "foo-service",
+                                   "v1alpha3", "", "", Istio::Common::WorkloadType::Pod, "");
+  EXPECT_CALL(*metadata_provider_, GetMetadata(_))
+      .WillRepeatedly(Return(std::make_shared<const WorkloadMetadataObject>(pod)));
+  initialize(R"EOF(
+    downstream_discovery:
+      - workload_discovery: {}
+    skip_cel_state: true
+  )EOF");
+  checkNoPeer(true);
+  const auto* peer = stream_info_.filterState()->getDataReadOnly<WorkloadMetadataHandle>(
+      Istio::Common::DownstreamPeerObject);
+  ASSERT_NE(nullptr, peer);
+  EXPECT_EQ("default", peer->workload()->namespace_name_);
+}
+
 TEST_F(PeerMetadataTest, UpstreamXDS) {
   const WorkloadMetadataObject pod("pod-foo-1234", "my-cluster", "foo", "foo", "foo-service",
                                    "v1alpha3", "", "", Istio::Common::WorkloadType::Pod, "");
   EXPECT_CALL(*metadata_provider_, GetMetadata(_))
       .WillRepeatedly(Invoke([&](const Network::Address::InstanceConstSharedPtr& address)
-                                 -> std::optional<WorkloadMetadataObject> {
+                                 -> WorkloadMetadataObjectConstSharedPtr {
         if (absl::StartsWith(address->asStringView(), "10.0.0.1")) {
-          return {pod};
+          return std::make_shared<const WorkloadMetadataObject>(pod);
         }
-        return {};
+        return nullptr;
       }));
   initialize(R"EOF(
     upstream_discovery:
@@ -194,11 +218,11 @@ TEST_F(PeerMetadataTest, UpstreamXDSInternal) {
                                    "v1alpha3", "", "", Istio::Common::WorkloadType::Pod, "");
   EXPECT_CALL(*metadata_provider_, GetMetadata(_))
       .WillRepeatedly(Invoke([&](const Network::Address::InstanceConstSharedPtr& address)
-                                 -> std::optional<WorkloadMetadataObject> {
+                                 -> WorkloadMetadataObjectConstSharedPtr {
         if (absl::StartsWith(address->asStringView(), "127.0.0.100")) {
-          return {pod};
+          return std::make_shared<const WorkloadMetadataObject>(pod);
         }
-        return {};
+        return nullptr;
       }));
   initialize(R"EOF(
     upstream_discovery:
@@ -263,11 +287,11 @@ TEST_F(PeerMetadataTest, DownstreamFallbackSecond) {
                                    "v1alpha3", "", "", Istio::Common::WorkloadType::Pod, "");
   EXPECT_CALL(*metadata_provider_, GetMetadata(_))
       .WillRepeatedly(Invoke([&](const Network::Address::InstanceConstSharedPtr& address)
-                                 -> std::optional<WorkloadMetadataObject> {
+                                 -> WorkloadMetadataObjectConstSharedPtr {
         if (absl::StartsWith(address->asStringView(), "127.0.0.1")) { // remote address
-          return {pod};
+          return std::make_shared<const WorkloadMetadataObject>(pod);
         }
-        return {};
+        return nullptr;
       }));
   initialize(R"EOF(
     downstream_discovery:
@@ -294,7 +318,7 @@ TEST(MXMethod, Cache) {
       request_headers.setReference(Headers::get().ExchangeMetadataHeader, SampleIstioHeader);
       Context ctx;
       const auto result = method.derivePeerInfo(stream_info, request_headers, ctx);
-      EXPECT_TRUE(result.has_value());
+      EXPECT_NE(result, nullptr);
     }
   }
 }
@@ -346,11 +370,11 @@ TEST_F(PeerMetadataTest, UpstreamFallbackSecond) {
                                    "v1alpha3", "", "", Istio::Common::WorkloadType::Pod, "");
   EXPECT_CALL(*metadata_provider_, GetMetadata(_))
       .WillRepeatedly(Invoke([&](const Network::Address::InstanceConstSharedPtr& address)
-                                 -> std::optional<WorkloadMetadataObject> {
+                                 -> WorkloadMetadataObjectConstSharedPtr {
         if (absl::StartsWith(address->asStringView(), "10.0.0.1")) { // upstream host address
-          return {pod};
+          return std::make_shared<const WorkloadMetadataObject>(pod);
         }
-        return {};
+        return nullptr;
       }));
   initialize(R"EOF(
     upstream_discovery:
@@ -368,11 +392,11 @@ TEST_F(PeerMetadataTest, UpstreamFallbackFirstXDS) {
                                    "v1alpha3", "", "", Istio::Common::WorkloadType::Pod, "");
   EXPECT_CALL(*metadata_provider_, GetMetadata(_))
       .WillRepeatedly(Invoke([&](const Network::Address::InstanceConstSharedPtr& address)
-                                 -> std::optional<WorkloadMetadataObject> {
+                                 -> WorkloadMetadataObjectConstSharedPtr {
         if (absl::StartsWith(address->asStringView(), "10.0.0.1")) { // upstream host address
-          return {pod};
+          return std::make_shared<const WorkloadMetadataObject>(pod);
         }
-        return {};
+        return nullptr;
       }));
   response_headers_.setReference(Headers::get().ExchangeMetadataHeaderId, "test-pod");
   response_headers_.setReference(Headers::get().ExchangeMetadataHeader, SampleIstioHeader);
@@ -459,8 +483,10 @@ TEST_F(PeerMetadataTest, UpstreamMXPropagationSkip) {
         istio:
           external: true
     )EOF");
+  const Config::TypedMetadataImpl<Upstream::ClusterTypedMetadataFactory> typed_metadata(metadata);
   ON_CALL(stream_info_, upstreamClusterInfo()).WillByDefault(testing::Return(cluster_info_));
   ON_CALL(*cluster_info_, metadata()).WillByDefault(ReturnRef(metadata));
+  ON_CALL(*cluster_info_, typedMetadata()).WillByDefault(ReturnRef(typed_metadata));
   initialize(R"EOF(
     upstream_propagation:
       - istio_headers:
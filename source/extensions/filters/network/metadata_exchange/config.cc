@@ -40,7 +40,7 @@ Network::FilterFactoryCb createFilterFactoryHelper(
 
   MetadataExchangeConfigSharedPtr filter_config(std::make_shared<MetadataExchangeConfig>(
       StatPrefix, proto_config.protocol(), filter_direction, proto_config.enable_discovery(),
-      additional_labels, context, context.scope()));
+      additional_labels, context, context.scope(), proto_config.skip_cel_state()));
   return [filter_config, &context](Network::FilterManager& filter_manager) -> void {
     filter_manager.addFilter(
         std::make_shared<MetadataExchangeFilter>(filter_config, context.localInfo()));
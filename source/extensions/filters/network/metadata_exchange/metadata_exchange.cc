@@ -64,12 +64,14 @@ MetadataExchangeConfig::MetadataExchangeConfig(
     const std::string& stat_prefix, const std::string& protocol,
     const FilterDirection filter_direction, bool enable_discovery,
     const absl::flat_hash_set<std::string> additional_labels,
-    Server::Configuration::ServerFactoryContext& factory_context, Stats::Scope& scope)
+    Server::Configuration::ServerFactoryContext& factory_context, Stats::Scope& scope,
+    bool skip_cel_state)
     : scope_(scope), stat_prefix_(stat_prefix), protocol_(protocol),
       filter_direction_(filter_direction), stats_(generateStats(stat_prefix, scope)),
-      additional_labels_(additional_labels) {
+      additional_labels_(additional_labels), skip_cel_state_(skip_cel_state) {
   if (enable_discovery) {
     metadata_provider_ = Extensions::Common::WorkloadDiscovery::GetProvider(factory_context);
+    host_metadata_ = Istio::Common::HostMetadataCache::get(factory_context);
   }
 }
 
@@ -263,26 +265,34 @@ void MetadataExchangeFilter::tryReadProxyData(Buffer::Instance& data) {
   ProtobufWkt::Struct value_struct = MessageUtil::anyConvert<ProtobufWkt::Struct>(proxy_data);
   auto key_metadata_it = value_struct.fields().find(ExchangeMetadataHeader);
   if (key_metadata_it != value_struct.fields().end()) {
-    updatePeer(*Istio::Common::convertStructToWorkloadMetadata(
+    updatePeer(Istio::Common::convertStructToWorkloadMetadata(
         key_metadata_it->second.struct_value(), config_->additional_labels_));
   }
 }
 
-void MetadataExchangeFilter::updatePeer(const Istio::Common::WorkloadMetadataObject& value) {
+void MetadataExchangeFilter::updatePeer(const WorkloadMetadataObjectConstSharedPtr& value) {
   updatePeer(value, config_->filter_direction_);
 }
 
-void MetadataExchangeFilter::updatePeer(const Istio::Common::WorkloadMetadataObject& value,
+void MetadataExchangeFilter::updatePeer(const WorkloadMetadataObjectConstSharedPtr& value,
                                         FilterDirection direction) {
-  auto filter_state_key = direction == FilterDirection::Downstream ? Istio::Common::DownstreamPeer
-                                                                   : Istio::Common::UpstreamPeer;
-  auto pb = value.serializeAsProto();
-  auto peer_info = std::make_shared<CelState>(MetadataExchangeConfig::peerInfoPrototype());
-  peer_info->setValue(absl::string_view(pb->SerializeAsString()));
+  if (!config_->skip_cel_state_) {
+    auto filter_state_key = direction == FilterDirection::Downstream
+                                ? Istio::Common::DownstreamPeer
+                                : Istio::Common::UpstreamPeer;
+    auto pb = value->serializeAsProto();
+    auto peer_info = std::make_shared<CelState>(MetadataExchangeConfig::peerInfoPrototype());
+    peer_info->setValue(absl::string_view(pb->SerializeAsString()));
 
+    read_callbacks_->connection().streamInfo().filterState()->setData(
+        filter_state_key, std::move(peer_info), StreamInfo::FilterState::StateType::Mutable,
+        StreamInfo::FilterState::LifeSpan::Connection);
+  }
   read_callbacks_->connection().streamInfo().filterState()->setData(
-      filter_state_key, std::move(peer_info), StreamInfo::FilterState::StateType::Mutable,
-      StreamInfo::FilterState::LifeSpan::Connection);
+      direction == FilterDirection::Downstream ? Istio::Common::DownstreamPeerObject
+                                               : Istio::Common::UpstreamPeerObject,
+      std::make_shared<Istio::Common::WorkloadMetadataHandle>(value),
+      StreamInfo::FilterState::StateType::Mutable, StreamInfo::FilterState::LifeSpan::Connection);
 }
 
 std::string MetadataExchangeFilter::getMetadataId() { return local_info_.node().id(); }
@@ -301,18 +311,11 @@ void MetadataExchangeFilter::setMetadataNotFoundFilterState() {
           upstream_peer = upstream_host->address();
           break;
         case Network::Address::Type::EnvoyInternal:
-          if (upstream_host->metadata()) {
+          if (const auto host_metadata = config_->host_metadata_->lookup(*upstream_host);
+              host_metadata) {
             ENVOY_LOG(debug, "Trying to check filter metadata of host {}",
                       upstream_host->address()->asString());
-            const auto& filter_metadata = upstream_host->metadata()->filter_metadata();
-            const auto& it = filter_metadata.find("envoy.filters.listener.original_dst");
-            if (it != filter_metadata.end()) {
-              const auto& destination_it = it->second.fields().find("local");
-              if (destination_it != it->second.fields().end()) {
-                upstream_peer = Network::Utility::parseInternetAddressAndPortNoThrow(
-                    destination_it->second.string_value(), /*v6only=*/false);
-              }
-            }
+            upstream_peer = host_metadata->original_dst_;
           }
           break;
         default:
@@ -328,7 +331,7 @@ void MetadataExchangeFilter::setMetadataNotFoundFilterState() {
         if (metadata_object) {
           ENVOY_LOG(debug, "Metadata found for upstream peer address {}",
                     upstream_peer->asString());
-          updatePeer(metadata_object.value(), FilterDirection::Upstream);
+          updatePeer(metadata_object, FilterDirection::Upstream);
         }
       }
 
@@ -350,7 +353,7 @@ void MetadataExchangeFilter::setMetadataNotFoundFilterState() {
     const auto metadata_object = config_->metadata_provider_->GetMetadata(peer_address);
     if (metadata_object) {
       ENVOY_LOG(trace, "Metadata found for peer address {}", peer_address->asString());
-      updatePeer(metadata_object.value());
+      updatePeer(metadata_object);
       config_->stats().metadata_added_.inc();
       return;
     } else {
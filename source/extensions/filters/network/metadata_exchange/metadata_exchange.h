@@ -29,6 +29,7 @@
 #include "source/extensions/filters/network/metadata_exchange/config/metadata_exchange.pb.h"
 #include "source/extensions/common/workload_discovery/api.h"
 
+#include "extensions/common/host_metadata.h"
 #include "extensions/common/metadata_object.h"
 
 namespace Envoy {
@@ -37,6 +38,7 @@ namespace MetadataExchange {
 
 using ::Envoy::Extensions::Filters::Common::Expr::CelStatePrototype;
 using ::Envoy::Extensions::Filters::Common::Expr::CelStateType;
+using ::Envoy::Extensions::Common::WorkloadDiscovery::WorkloadMetadataObjectConstSharedPtr;
 
 /**
  * All MetadataExchange filter stats. @see stats_macros.h
@@ -70,7 +72,7 @@ public:
                          const FilterDirection filter_direction, bool enable_discovery,
                          const absl::flat_hash_set<std::string> additional_labels,
                          Server::Configuration::ServerFactoryContext& factory_context,
-                         Stats::Scope& scope);
+                         Stats::Scope& scope, bool skip_cel_state = false);
 
   const MetadataExchangeStats& stats() { return stats_; }
 
@@ -84,9 +86,13 @@ public:
   const FilterDirection filter_direction_;
   // Set if WDS is enabled.
   Extensions::Common::WorkloadDiscovery::WorkloadMetadataProviderSharedPtr metadata_provider_;
+  // Cache of the upstream host metadata, set if WDS is enabled.
+  Istio::Common::HostMetadataCacheSharedPtr host_metadata_;
   // Stats for MetadataExchange Filter.
   MetadataExchangeStats stats_;
   const absl::flat_hash_set<std::string> additional_labels_;
+  // Set if only the typed peer object is stored.
+  const bool skip_cel_state_;
 
   static const CelStatePrototype& peerInfoPrototype() {
     static const CelStatePrototype* const prototype = new CelStatePrototype(
@@ -137,9 +143,11 @@ private:
   // form of google::protobuf::any which encapsulates google::protobuf::struct.
   void tryReadProxyData(Buffer::Instance& data);
 
-  // Helper function to share the metadata with other filters.
-  void updatePeer(const Istio::Common::WorkloadMetadataObject& obj, FilterDirection direction);
-  void updatePeer(const Istio::Common::WorkloadMetadataObject& obj);
+  // Helper function to share the metadata with other filters. The handle is
+  // mutable, so that a later filter may replace the peer, but the object it
+  // points to is immutable and may be shared with the workload discovery index.
+  void updatePeer(const WorkloadMetadataObjectConstSharedPtr& obj, FilterDirection direction);
+  void updatePeer(const WorkloadMetadataObjectConstSharedPtr& obj);
 
   // Helper function to get metadata id.
   std::string getMetadataId();
@@ -149,6 +149,35 @@ func (me *PartialStat) Matches(params *Params, that *dto.MetricFamily) error {
 
 var _ StatMatcher = &PartialStat{}
 
+// HistogramSampleCount matches if the histograms of the family record the
+// given number of samples in total, and all carry the given labels.
+type HistogramSampleCount struct {
+	Count  uint64
+	Labels map[string]string
+}
+
+func (me *HistogramSampleCount) Matches(_ *Params, that *dto.MetricFamily) error {
+	var count uint64
+	for _, metric := range that.Metric {
+		labels := make(map[string]string)
+		for _, label := range metric.Label {
+			labels[label.GetName()] = label.GetValue()
+		}
+		for name, value := range me.Labels {
+			if labels[name] != value {
+				return fmt.Errorf("label %q: got %q, want %q", name, labels[name], value)
+			}
+		}
+		count += metric.GetHistogram().GetSampleCount()
+	}
+	if count != me.Count {
+		return fmt.Errorf("sample count: got %d, want %d", count, me.Count)
+	}
+	return nil
+}
+
+var _ StatMatcher = &HistogramSampleCount{}
+
 type MissingStat struct {
 	Metric string
 }
@@ -107,7 +107,14 @@ func handleConnection(conn net.Conn, prefix string) {
 	}
 }
 
-type TCPConnection struct{}
+type TCPConnection struct {
+	// Messages is the number of request/reply exchanges on the connection, at least one.
+	Messages int
+	// Idle is the time the connection stays open without traffic between the exchanges.
+	Idle time.Duration
+	// Linger is the time the connection stays open after the last exchange.
+	Linger time.Duration
+}
 
 var _ Step = &TCPConnection{}
 
@@ -117,17 +124,24 @@ func (t *TCPConnection) Run(p *Params) error {
 		return fmt.Errorf("failed to connect to tcp server: %v", err)
 	}
 	defer conn.Close()
-	// send to socket
-	fmt.Fprintf(conn, "world"+"\n")
-	// listen for reply
-	message, err := bufio.NewReader(conn).ReadString('\n')
-	if err != nil {
-		return fmt.Errorf("failed to read bytes from conn %v", err)
-	}
-	wantMessage := "hello world\n"
-	if message != wantMessage {
-		return fmt.Errorf("received bytes got %v want %v", message, wantMessage)
+	reader := bufio.NewReader(conn)
+	for i := 0; i < t.Messages || i == 0; i++ {
+		if i > 0 {
+			time.Sleep(t.Idle)
+		}
+		// send to socket
+		fmt.Fprintf(conn, "world"+"\n")
+		// listen for reply
+		message, err := reader.ReadString('\n')
+		if err != nil {
+			return fmt.Errorf("failed to read bytes from conn %v", err)
+		}
+		wantMessage := "hello world\n"
+		if message != wantMessage {
+			return fmt.Errorf("received bytes got %v want %v", message, wantMessage)
+		}
 	}
+	time.Sleep(t.Linger)
 	return nil
 }
 
@@ -49,9 +49,20 @@ func init() {
 		"TestStatsPayload/Customized/",
 		"TestStatsPayload/Default/",
 		"TestStatsPayload/DisableHostHeader/",
+		"TestStatsPayload/ExpressionParity/",
+		"TestStatsPayload/HistogramSampling/",
+		"TestStatsPayload/MatchDrop/",
+		"TestStatsPayload/MatchDropAll/",
+		"TestStatsPayload/WorkerFlush/",
 		"TestStatsPayload/UseHostHeader/",
 		"TestStatsParserRegression",
 		"TestStatsExpiry",
+		"TestStatsHistogramSampling",
+		"TestStatsIdleExpiry",
+		"TestStatsSeriesOverflow",
+		"TestStatsSeriesOverflowSharded",
+		"TestStatsTypedValues",
+		"TestStatsTCPIdleBackoff",
 		"TestTCPMetadataExchange/false",
 		"TestTCPMetadataExchange/true",
 		"TestTCPMetadataExchangeNoAlpn",
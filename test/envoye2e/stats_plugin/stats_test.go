@@ -89,6 +89,72 @@ var TestCases = []struct {
 		},
 		TestParallel: true,
 	},
+	{
+		Name:         "MatchDrop",
+		ClientConfig: "testdata/stats/client_config_match.yaml",
+		ServerConfig: "testdata/stats/server_config.yaml",
+		ClientStats: map[string]driver.StatMatcher{
+			// Only the metrics with a matching expression are dropped.
+			"istio_requests_total":                &driver.ExactStat{Metric: "testdata/metric/client_request_total.yaml.tmpl"},
+			"istio_request_duration_milliseconds": &driver.MissingStat{Metric: "istio_request_duration_milliseconds"},
+		},
+		ServerStats: map[string]driver.StatMatcher{
+			"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/server_request_total.yaml.tmpl"},
+		},
+	},
+	{
+		Name:         "MatchDropAll",
+		ClientConfig: "testdata/stats/client_config_match_all.yaml",
+		ServerConfig: "testdata/stats/server_config.yaml",
+		ClientStats: map[string]driver.StatMatcher{
+			// The requests dropping all their metrics are not reported at all.
+			"istio_requests_total":                &driver.MissingStat{Metric: "istio_requests_total"},
+			"istio_request_duration_milliseconds": &driver.MissingStat{Metric: "istio_request_duration_milliseconds"},
+			"istio_request_bytes":                 &driver.MissingStat{Metric: "istio_request_bytes"},
+			"istio_response_bytes":                &driver.MissingStat{Metric: "istio_response_bytes"},
+		},
+		ServerStats: map[string]driver.StatMatcher{
+			"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/server_request_total.yaml.tmpl"},
+		},
+	},
+	{
+		Name:         "WorkerFlush",
+		ClientConfig: "testdata/stats/client_config_worker_flush.yaml",
+		ServerConfig: "testdata/stats/server_config.yaml",
+		ClientStats: map[string]driver.StatMatcher{
+			// The increments accumulated on the workers are applied at the flush interval.
+			"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/client_request_total.yaml.tmpl"},
+		},
+		ServerStats: map[string]driver.StatMatcher{
+			"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/server_request_total.yaml.tmpl"},
+		},
+	},
+	{
+		Name:         "HistogramSampling",
+		ClientConfig: "testdata/stats/client_config_histogram_sampling.yaml",
+		ServerConfig: "testdata/stats/server_config.yaml",
+		ClientStats: map[string]driver.StatMatcher{
+			"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/client_request_total.yaml.tmpl"},
+			// The largest denominator samples out all requests in practice.
+			"istio_request_duration_milliseconds": &driver.MissingStat{Metric: "istio_request_duration_milliseconds"},
+			"istio_request_bytes":                 &driver.MissingStat{Metric: "istio_request_bytes"},
+			"istio_response_bytes":                &driver.MissingStat{Metric: "istio_response_bytes"},
+		},
+		ServerStats: map[string]driver.StatMatcher{
+			"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/server_request_total.yaml.tmpl"},
+		},
+	},
+	{
+		Name:         "ExpressionParity",
+		ClientConfig: "testdata/stats/client_config_expression_parity.yaml",
+		ServerConfig: "testdata/stats/server_config.yaml",
+		ClientStats: map[string]driver.StatMatcher{
+			"istio_parity": &driver.ExactStat{Metric: "testdata/metric/client_expression_parity.yaml.tmpl"},
+		},
+		ServerStats: map[string]driver.StatMatcher{
+			"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/server_request_total.yaml.tmpl"},
+		},
+	},
 	{
 		Name:              "UseHostHeader",
 		ClientConfig:      "testdata/stats/client_config.yaml",
@@ -937,6 +1003,266 @@ func TestStatsExpiry(t *testing.T) {
 	}
 }
 
+// TestStatsTypedValues checks the integer, unsigned, boolean and string
+// results of the expressions over a sustained run of requests, each stream
+// evaluating all expressions on a single arena.
+func TestStatsTypedValues(t *testing.T) {
+	params := driver.NewTestParams(t, map[string]string{
+		"RequestCount":            "200",
+		"TypedCount":              "600",
+		"StatsConfig":             driver.LoadTestData("testdata/bootstrap/stats.yaml.tmpl"),
+		"StatsFilterClientConfig": driver.LoadTestJSON("testdata/stats/client_config_typed_values.yaml"),
+		"StatsFilterServerConfig": driver.LoadTestJSON("testdata/stats/server_config.yaml"),
+	}, envoye2e.ProxyE2ETests)
+	params.Vars["ClientMetadata"] = params.LoadTestData("testdata/client_node_metadata.json.tmpl")
+	params.Vars["ServerMetadata"] = params.LoadTestData("testdata/server_node_metadata.json.tmpl")
+	enableStats(t, params.Vars)
+	if err := (&driver.Scenario{
+		Steps: []driver.Step{
+			&driver.XDS{},
+			&driver.Update{
+				Node:      "client",
+				Version:   "0",
+				Clusters:  []string{params.LoadTestData("testdata/cluster/server.yaml.tmpl")},
+				Listeners: []string{params.LoadTestData("testdata/listener/client.yaml.tmpl")},
+			},
+			&driver.Update{Node: "server", Version: "0", Listeners: []string{params.LoadTestData("testdata/listener/server.yaml.tmpl")}},
+			&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/server.yaml.tmpl")},
+			&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/client.yaml.tmpl")},
+			&driver.Sleep{Duration: 1 * time.Second},
+			&driver.Repeat{
+				N:    200,
+				Step: driver.Get(params.Ports.ClientPort, "hello, world!"),
+			},
+			&driver.Stats{AdminPort: params.Ports.ClientAdmin, Matchers: map[string]driver.StatMatcher{
+				"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/client_request_total.yaml.tmpl"},
+				"istio_typed":          &driver.ExactStat{Metric: "testdata/metric/client_typed_values.yaml.tmpl"},
+			}},
+		},
+	}).Run(params); err != nil {
+		t.Fatal(err)
+	}
+}
+
+// TestStatsHistogramSampling checks that 1 in N requests record the
+// histograms, selected by the leading bits of the request ID, and that the
+// sampled histograms are tagged with N.
+func TestStatsHistogramSampling(t *testing.T) {
+	params := driver.NewTestParams(t, map[string]string{
+		"RequestCount":            "8",
+		"StatsConfig":             driver.LoadTestData("testdata/bootstrap/stats.yaml.tmpl"),
+		"StatsFilterClientConfig": driver.LoadTestJSON("testdata/stats/client_config_histogram_sampling_small.yaml"),
+		"StatsFilterServerConfig": driver.LoadTestJSON("testdata/stats/server_config.yaml"),
+	}, envoye2e.ProxyE2ETests)
+	params.Vars["ClientMetadata"] = params.LoadTestData("testdata/client_node_metadata.json.tmpl")
+	params.Vars["ServerMetadata"] = params.LoadTestData("testdata/server_node_metadata.json.tmpl")
+	enableStats(t, params.Vars)
+	steps := []driver.Step{
+		&driver.XDS{},
+		&driver.Update{
+			Node:      "client",
+			Version:   "0",
+			Clusters:  []string{params.LoadTestData("testdata/cluster/server.yaml.tmpl")},
+			Listeners: []string{params.LoadTestData("testdata/listener/client.yaml.tmpl")},
+		},
+		&driver.Update{Node: "server", Version: "0", Listeners: []string{params.LoadTestData("testdata/listener/server.yaml.tmpl")}},
+		&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/server.yaml.tmpl")},
+		&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/client.yaml.tmpl")},
+		&driver.Sleep{Duration: 1 * time.Second},
+	}
+	// The stream ID is the integer value of the first 8 hex digits of the
+	// request ID, so the IDs 4 and 8 out of 1 to 8 are sampled with N = 4.
+	for i := 1; i <= 8; i++ {
+		steps = append(steps, &driver.HTTPCall{
+			Port:           params.Ports.ClientPort,
+			Body:           "hello, world!",
+			RequestHeaders: map[string]string{"x-request-id": fmt.Sprintf("%08x-0000-4000-8000-000000000000", i)},
+		})
+	}
+	sampled := &driver.HistogramSampleCount{Count: 2, Labels: map[string]string{"sampling_denominator": "4"}}
+	steps = append(steps, &driver.Stats{AdminPort: params.Ports.ClientAdmin, Matchers: map[string]driver.StatMatcher{
+		"istio_requests_total":                &driver.ExactStat{Metric: "testdata/metric/client_request_total.yaml.tmpl"},
+		"istio_request_duration_milliseconds": sampled,
+		"istio_request_bytes":                 sampled,
+		"istio_response_bytes":                sampled,
+	}})
+	if err := (&driver.Scenario{Steps: steps}).Run(params); err != nil {
+		t.Fatal(err)
+	}
+}
+
+// TestStatsSeriesOverflow checks that the series beyond the limit of a metric
+// are reported in the overflow series, and that each rejected series is
+// counted once.
+func TestStatsSeriesOverflow(t *testing.T) {
+	runSeriesOverflow(t, "testdata/stats/client_config_series_overflow.yaml",
+		[]string{"a", "b", "b", "c"},
+		"testdata/metric/client_series_overflow.yaml.tmpl",
+		"testdata/metric/istio_stats_series_overflow.yaml")
+}
+
+// TestStatsSeriesOverflowSharded checks that the limit of a metric holds
+// across the scope shards, wherever the series are hashed to.
+func TestStatsSeriesOverflowSharded(t *testing.T) {
+	runSeriesOverflow(t, "testdata/stats/client_config_series_overflow_sharded.yaml",
+		[]string{"a", "b", "c", "d", "e", "f", "g", "h"},
+		"testdata/metric/client_series_overflow_sharded.yaml.tmpl",
+		"testdata/metric/istio_stats_series_overflow_sharded.yaml")
+}
+
+func runSeriesOverflow(t *testing.T, config string, series []string, metric, overflow string) {
+	params := driver.NewTestParams(t, map[string]string{
+		"RequestCount":            strconv.Itoa(len(series)),
+		"StatsConfig":             driver.LoadTestData("testdata/bootstrap/stats.yaml.tmpl"),
+		"StatsFilterClientConfig": driver.LoadTestJSON(config),
+		"StatsFilterServerConfig": driver.LoadTestJSON("testdata/stats/server_config.yaml"),
+	}, envoye2e.ProxyE2ETests)
+	params.Vars["ClientMetadata"] = params.LoadTestData("testdata/client_node_metadata.json.tmpl")
+	params.Vars["ServerMetadata"] = params.LoadTestData("testdata/server_node_metadata.json.tmpl")
+	enableStats(t, params.Vars)
+	steps := []driver.Step{
+		&driver.XDS{},
+		&driver.Update{
+			Node:      "client",
+			Version:   "0",
+			Clusters:  []string{params.LoadTestData("testdata/cluster/server.yaml.tmpl")},
+			Listeners: []string{params.LoadTestData("testdata/listener/client.yaml.tmpl")},
+		},
+		&driver.Update{Node: "server", Version: "0", Listeners: []string{params.LoadTestData("testdata/listener/server.yaml.tmpl")}},
+		&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/server.yaml.tmpl")},
+		&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/client.yaml.tmpl")},
+		&driver.Sleep{Duration: 1 * time.Second},
+	}
+	for _, value := range series {
+		steps = append(steps, &driver.HTTPCall{
+			Port:           params.Ports.ClientPort,
+			Body:           "hello, world!",
+			RequestHeaders: map[string]string{"x-series": value},
+		})
+	}
+	steps = append(steps, &driver.Stats{AdminPort: params.Ports.ClientAdmin, Matchers: map[string]driver.StatMatcher{
+		"istio_requests_total":              &driver.ExactStat{Metric: "testdata/metric/client_request_total.yaml.tmpl"},
+		"istio_series":                      &driver.PartialStat{Metric: metric},
+		"envoy_istio_stats_series_overflow": &driver.ExactStat{Metric: overflow},
+	}})
+	if err := (&driver.Scenario{Steps: steps}).Run(params); err != nil {
+		t.Fatal(err)
+	}
+}
+
+// TestStatsIdleExpiry checks that the series written within the idle timeout
+// keep their values across the rotations of the sharded scopes, and that the
+// idle series expire.
+func TestStatsIdleExpiry(t *testing.T) {
+	params := driver.NewTestParams(t, map[string]string{
+		"RequestCount":            "7",
+		"StatsConfig":             driver.LoadTestData("testdata/bootstrap/stats.yaml.tmpl"),
+		"StatsFilterClientConfig": driver.LoadTestJSON("testdata/stats/client_config_idle_expiry.yaml"),
+		"StatsFilterServerConfig": driver.LoadTestJSON("testdata/stats/server_config.yaml"),
+	}, envoye2e.ProxyE2ETests)
+	params.Vars["ClientMetadata"] = params.LoadTestData("testdata/client_node_metadata.json.tmpl")
+	params.Vars["ServerMetadata"] = params.LoadTestData("testdata/server_node_metadata.json.tmpl")
+	enableStats(t, params.Vars)
+	call := &driver.HTTPCall{
+		Port: params.Ports.ClientPort,
+		Body: "hello, world!",
+	}
+	if err := (&driver.Scenario{
+		Steps: []driver.Step{
+			&driver.XDS{},
+			&driver.Update{
+				Node:      "client",
+				Version:   "0",
+				Clusters:  []string{params.LoadTestData("testdata/cluster/server.yaml.tmpl")},
+				Listeners: []string{params.LoadTestData("testdata/listener/client.yaml.tmpl")},
+			},
+			&driver.Update{Node: "server", Version: "0", Listeners: []string{params.LoadTestData("testdata/listener/server.yaml.tmpl")}},
+			&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/server.yaml.tmpl")},
+			&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/client.yaml.tmpl")},
+			&driver.Sleep{Duration: 1 * time.Second},
+			call,
+			// Write the series for longer than the idle timeout, over several
+			// rotations of each scope.
+			&driver.Repeat{
+				N: 6,
+				Step: &driver.Scenario{Steps: []driver.Step{
+					&driver.Sleep{Duration: 1 * time.Second},
+					call,
+				}},
+			},
+			&driver.Stats{AdminPort: params.Ports.ClientAdmin, Matchers: map[string]driver.StatMatcher{
+				"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/client_request_total.yaml.tmpl"},
+			}},
+			&driver.Sleep{Duration: 8 * time.Second},
+			&driver.Stats{AdminPort: params.Ports.ClientAdmin, Matchers: map[string]driver.StatMatcher{
+				"istio_requests_total": &driver.MissingStat{Metric: "istio_requests_total"},
+				"istio_build":          &driver.ExactStat{Metric: "testdata/metric/istio_build.yaml"},
+			}},
+		},
+	}).Run(params); err != nil {
+		t.Fatal(err)
+	}
+}
+
+// TestStatsTCPIdleBackoff checks that the bytes of a TCP connection resuming
+// traffic after its periodic reports backed off are reported at the next
+// interval, before the connection closes.
+func TestStatsTCPIdleBackoff(t *testing.T) {
+	params := driver.NewTestParams(t, map[string]string{
+		"DisableDirectResponse": "true",
+		"AlpnProtocol":          "mx-protocol",
+		"StatsConfig":           driver.LoadTestData("testdata/bootstrap/stats.yaml.tmpl"),
+	}, envoye2e.ProxyE2ETests)
+	params.Vars["ClientMetadata"] = params.LoadTestData("testdata/client_node_metadata.json.tmpl")
+	params.Vars["ServerMetadata"] = params.LoadTestData("testdata/server_node_metadata.json.tmpl")
+	params.Vars["ServerNetworkFilters"] = params.LoadTestData("testdata/filters/server_mx_network_filter.yaml.tmpl") + "\n" +
+		params.LoadTestData("testdata/filters/server_stats_network_filter.yaml.tmpl")
+	params.Vars["ClientUpstreamFilters"] = params.LoadTestData("testdata/filters/client_mx_network_filter.yaml.tmpl")
+	params.Vars["ClientNetworkFilters"] = params.LoadTestData("testdata/filters/client_stats_network_filter.yaml.tmpl")
+	params.Vars["ClientClusterTLSContext"] = params.LoadTestData("testdata/transport_socket/client.yaml.tmpl")
+	params.Vars["ServerListenerTLSContext"] = params.LoadTestData("testdata/transport_socket/server.yaml.tmpl")
+
+	if err := (&driver.Scenario{
+		Steps: []driver.Step{
+			&driver.XDS{},
+			&driver.Update{
+				Node:      "client",
+				Version:   "0",
+				Clusters:  []string{params.LoadTestData("testdata/cluster/tcp_client.yaml.tmpl")},
+				Listeners: []string{params.LoadTestData("testdata/listener/tcp_client.yaml.tmpl")},
+			},
+			&driver.Update{
+				Node:      "server",
+				Version:   "0",
+				Clusters:  []string{params.LoadTestData("testdata/cluster/tcp_server.yaml.tmpl")},
+				Listeners: []string{params.LoadTestData("testdata/listener/tcp_server.yaml.tmpl")},
+			},
+			&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/client.yaml.tmpl")},
+			&driver.Envoy{Bootstrap: params.LoadTestData("testdata/bootstrap/server.yaml.tmpl")},
+			&driver.Sleep{Duration: 1 * time.Second},
+			&driver.TCPServer{Prefix: "hello"},
+			&driver.Fork{
+				// The 1s reporting duration backs off to 8s during the idle time.
+				Back: &driver.TCPConnection{Messages: 2, Idle: 9 * time.Second, Linger: 10 * time.Second},
+				Fore: &driver.Scenario{
+					Steps: []driver.Step{
+						&driver.Sleep{Duration: 11 * time.Second},
+						&driver.Stats{AdminPort: params.Ports.ClientAdmin, Matchers: map[string]driver.StatMatcher{
+							"istio_tcp_received_bytes_total": &driver.ExactStat{Metric: "testdata/metric/tcp_client_idle_received_bytes.yaml.tmpl"},
+							"istio_tcp_sent_bytes_total":     &driver.ExactStat{Metric: "testdata/metric/tcp_client_idle_sent_bytes.yaml.tmpl"},
+						}},
+						&driver.Stats{AdminPort: params.Ports.ClientAdmin, Matchers: map[string]driver.StatMatcher{
+							"istio_tcp_connections_closed_total": &driver.MissingStat{Metric: "istio_tcp_connections_closed_total"},
+						}},
+					},
+				},
+			},
+		},
+	}).Run(params); err != nil {
+		t.Fatal(err)
+	}
+}
+
 func TestStatsDestinationServiceNamespacePrecedence(t *testing.T) {
 	clientStats := map[string]driver.StatMatcher{
 		"istio_requests_total": &driver.ExactStat{Metric: "testdata/metric/client_request_total_cluster_metadata_precedence.yaml.tmpl"},